@@ -0,0 +1,314 @@
+/// bench.c
+/// Benchmarks for the timing and ramp resolvers.
+///
+/// Build and run with
+///     make bench
+///     ./bench [output.csv]
+///     ./bench --scaling [output.csv]
+///
+/// Each resolver is timed on three parameter mixes at several batch sizes:
+///     random       fields drawn so that every status branch is reached
+///     adversarial  cycles through every branch in turn (worst case for the
+///                  branch predictor)
+///     uniform      always fs + N, the common front panel case
+/// ETP_check is timed on the same cases converted to ticks of an 80 MHz
+/// timebase, to compare the exact resolver with TP_check.
+/// A batch of inputs is timed with mu_timer_real from minunit.h, and repeated
+/// until about a million resolutions have been timed. The table on stdout
+/// gives the mean ns/op, ops/s and the 50th, 90th and 99th percentile of the
+/// per-batch ns/op. If a file name is given, the same numbers are written to
+/// it as CSV, to compare the resolver hot path between releases.
+/// Batches of one resolution are dominated by the timer's own overhead
+/// (tens of ns); use them to compare releases, not as absolute latencies.
+///
+/// --scaling instead times TP_check_parallel and RP_check_parallel on a sweep
+/// of SCALING_N random points with 1 up to the number of online cores, and
+/// reports the best of SCALING_REPS runs and the speedup over one thread.
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+// Only the timers of minunit.h are used here, not its test counters.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#include "minunit.h"
+#pragma GCC diagnostic pop
+#include "check-timing.h"
+#include "exact-timing.h"
+#include "ramp.h"
+#include "sweep.h"
+
+#define MAX_BATCH 65536
+#define TARGET_OPS 1000000
+#define SCALING_N (1 << 21)
+#define SCALING_REPS 5
+// Timebase of the ETP_check inputs (Hz), as on an 80 MHz card.
+#define ETP_TIMEBASE 80000000
+
+enum { MIX_RANDOM, MIX_ADVERSARIAL, MIX_UNIFORM, N_MIXES };
+static const char* mix_names[] = {"random", "adversarial", "uniform"};
+
+// Inputs, which every timed run starts from, and the working copies.
+static double in_fs[MAX_BATCH], in_dt[MAX_BATCH], in_N[MAX_BATCH],
+              in_T[MAX_BATCH], in_eps[MAX_BATCH];
+static RampParameter in_rp[MAX_BATCH];
+static double fs[MAX_BATCH], dt[MAX_BATCH], N[MAX_BATCH], T[MAX_BATCH];
+static int status[MAX_BATCH];
+static TimingParameter tps[MAX_BATCH];
+static ExactTimingParameter in_etp[MAX_BATCH], etps[MAX_BATCH];
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double) RAND_MAX;
+}
+
+// One input from each branch of fs_dt_consistent / N_T_consistent, in order:
+// fs+N, fs+T, dt+N, dt+T, N+T, all four (3), N+T with a dt whose inverse
+// underflows (-2), nothing (-1), fs only (-1).
+static void branch_case(int branch, TimingParameter* tp) {
+    static const double cases[][4] = {
+        {1000, 0, 100, 0}, {1000, 0, 0, 0.5}, {0, 1e-3, 100, 0},
+        {0, 1e-3, 0, 0.5}, {0, 0, 100, 0.5}, {200, 5e-3, 100, 0.5},
+        {0, 1.0 / 0.0, 100, 0.5}, {0, 0, 0, 0}, {1000, 0, 0, 0}
+    };
+    const double* c = cases[branch % (sizeof(cases) / sizeof(cases[0]))];
+    TP_init_inplace(tp, c[0], c[1], c[2], c[3]);
+}
+
+// x seconds in ticks of ETP_TIMEBASE, or 0 if undefined or out of range.
+static int64_t ticks(double x) {
+    return x > 0 && x < 1e9 ? (int64_t) floor(x * ETP_TIMEBASE + 0.5) : 0;
+}
+
+static void make_inputs(int mix) {
+    srand(2014);
+    for (int i = 0; i < MAX_BATCH; i++) {
+        TimingParameter tp;
+        if (mix == MIX_ADVERSARIAL) {
+            branch_case(i, &tp);
+        }
+        else if (mix == MIX_UNIFORM) {
+            TP_init_inplace(&tp, uniform(1, 1e6), 0, floor(uniform(2, 1e6)), 0);
+        }
+        else {
+            branch_case(rand(), &tp);
+            tp.fs *= uniform(0.5, 2);
+            tp.N = floor(tp.N * uniform(0.5, 2));
+        }
+        in_fs[i] = tp.fs;
+        in_dt[i] = tp.dt;
+        in_N[i] = tp.N;
+        in_T[i] = tp.T;
+        in_eps[i] = tp.eps;
+        // The same case in ticks; fs and dt both become ticks per sample.
+        double period = tp.dt > 0 ? tp.dt : (tp.fs > 0 ? 1 / tp.fs : 0);
+        ETP_init_ticks(&in_etp[i], ETP_TIMEBASE, ticks(period),
+                       (int64_t) fmin(tp.N, 1e18), ticks(tp.T));
+        // Ramps: dydt or dy left undefined in the same proportions.
+        double dydt = (mix == MIX_UNIFORM || rand() % 4) ? uniform(0.1, 10) : 0;
+        double dy = (mix == MIX_UNIFORM || rand() % 4) ? uniform(1e-4, 0.1) : 0;
+        RP_init_inplace(&in_rp[i], uniform(-10, 10), uniform(-10, 10), dydt, dy);
+    }
+}
+
+static void reset_batch(int n) {
+    memcpy(fs, in_fs, n * sizeof(double));
+    memcpy(dt, in_dt, n * sizeof(double));
+    memcpy(N, in_N, n * sizeof(double));
+    memcpy(T, in_T, n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        TP_init_inplace(&tps[i], in_fs[i], in_dt[i], in_N[i], in_T[i]);
+    }
+    memcpy(etps, in_etp, n * sizeof(ExactTimingParameter));
+}
+
+enum {
+    FN_FS_DT, FN_N_T, FN_TP_CHECK, FN_TP_CHECK_BATCH, FN_TP_CHECK_BATCH_FIXED,
+    FN_RP_CHECK, FN_ETP_CHECK, N_FNS
+};
+static const char* fn_names[] = {
+    "fs_dt_consistent", "N_T_consistent", "TP_check", "TP_check_batch",
+    "TP_check_batch_fixed", "RP_check", "ETP_check"
+};
+
+static void run_batch(int fn, int n) {
+    switch (fn) {
+    case FN_FS_DT:
+        for (int i = 0; i < n; i++) {
+            status[i] = fs_dt_consistent(&tps[i]);
+        }
+        break;
+    case FN_N_T:
+        for (int i = 0; i < n; i++) {
+            status[i] = N_T_consistent(&tps[i]);
+        }
+        break;
+    case FN_TP_CHECK:
+        for (int i = 0; i < n; i++) {
+            status[i] = TP_check(&tps[i]);
+        }
+        break;
+    case FN_TP_CHECK_BATCH:
+        TP_check_batch(fs, dt, N, T, in_eps, status, n);
+        break;
+    case FN_TP_CHECK_BATCH_FIXED:
+        TP_check_batch_fixed(fs, dt, N, T, in_eps, status, n);
+        break;
+    case FN_RP_CHECK:
+        for (int i = 0; i < n; i++) {
+            status[i] = RP_check(&in_rp[i], &tps[i]);
+        }
+        break;
+    case FN_ETP_CHECK:
+        for (int i = 0; i < n; i++) {
+            status[i] = ETP_check(&etps[i]);
+        }
+        break;
+    }
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// Time the parallel sweeps at every thread count up to the number of cores.
+static int scaling(FILE* csv) {
+    size_t n = SCALING_N;
+    double* in = malloc(4 * n * sizeof(double));
+    double* work = sweep_alloc(4 * n * sizeof(double));
+    double* eps = malloc(n * sizeof(double));
+    int* out = sweep_alloc(n * sizeof(int));
+    RampParameter* rp = malloc(n * sizeof(RampParameter));
+    TimingParameter* tp = sweep_alloc(n * sizeof(TimingParameter));
+    if (!in || !work || !eps || !out || !rp || !tp) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    srand(2014);
+    for (size_t i = 0; i < n; i++) {
+        TimingParameter t;
+        branch_case(rand(), &t);
+        in[i] = t.fs * uniform(0.5, 2);
+        in[n + i] = t.dt;
+        in[2 * n + i] = floor(t.N * uniform(0.5, 2));
+        in[3 * n + i] = t.T;
+        eps[i] = t.eps;
+        RP_init_inplace(&rp[i], uniform(-10, 10), uniform(-10, 10),
+                        uniform(0.1, 10), uniform(1e-4, 0.1));
+    }
+    long n_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_cores < 1) {
+        n_cores = 1;
+    }
+    if (csv) {
+        fprintf(csv, "function,threads,n,ns_per_op,ops_per_s,speedup\n");
+    }
+    printf("%-18s %7s %10s %14s %8s\n", "function", "threads", "ns/op",
+           "ops/s", "speedup");
+    for (int fn = 0; fn < 2; fn++) {
+        const char* name = fn == 0 ? "TP_check_parallel" : "RP_check_parallel";
+        double single = 0;
+        for (int threads = 1; threads <= n_cores; threads++) {
+            double best = 1e300;
+            for (int r = 0; r < SCALING_REPS; r++) {
+                memcpy(work, in, 4 * n * sizeof(double));
+                for (size_t i = 0; i < n; i++) {
+                    TP_init_inplace(&tp[i], 0, 0, 0, 0);
+                }
+                double start = mu_timer_real();
+                if (fn == 0) {
+                    TP_check_parallel(work, work + n, work + 2 * n,
+                                      work + 3 * n, eps, out, n, threads);
+                }
+                else {
+                    RP_check_parallel(rp, tp, out, n, threads);
+                }
+                double elapsed = mu_timer_real() - start;
+                best = elapsed < best ? elapsed : best;
+            }
+            if (threads == 1) {
+                single = best;
+            }
+            double ns_per_op = best * 1e9 / n;
+            printf("%-18s %7d %10.2f %14.0f %8.2f\n", name, threads,
+                   ns_per_op, 1e9 / ns_per_op, single / best);
+            if (csv) {
+                fprintf(csv, "%s,%d,%zu,%.3f,%.0f,%.3f\n", name, threads, n,
+                        ns_per_op, 1e9 / ns_per_op, single / best);
+            }
+        }
+    }
+    free(in);
+    free(work);
+    free(eps);
+    free(out);
+    free(rp);
+    free(tp);
+    return 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    static const int batch_sizes[] = {1, 16, 256, 4096, MAX_BATCH};
+    static double samples[TARGET_OPS];
+    FILE* csv = NULL;
+    int scaling_mode = argc > 1 && strcmp(argv[1], "--scaling") == 0;
+    const char* csv_path = argc > 1 + scaling_mode ? argv[1 + scaling_mode] : NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            perror(csv_path);
+            return 1;
+        }
+    }
+    if (scaling_mode) {
+        int code = scaling(csv);
+        if (csv) {
+            fclose(csv);
+        }
+        return code;
+    }
+    if (csv) {
+        fprintf(csv, "function,mix,batch,reps,ns_per_op,ops_per_s,"
+                     "p50_ns,p90_ns,p99_ns\n");
+    }
+    printf("%-20s %-12s %6s %10s %14s %10s %10s %10s\n", "function", "mix",
+           "batch", "ns/op", "ops/s", "p50", "p90", "p99");
+
+    for (int mix = 0; mix < N_MIXES; mix++) {
+        make_inputs(mix);
+        for (int fn = 0; fn < N_FNS; fn++) {
+            for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(int); b++) {
+                int n = batch_sizes[b];
+                int reps = TARGET_OPS / n;
+                double total = 0;
+                for (int r = 0; r < reps; r++) {
+                    reset_batch(n);
+                    double start = mu_timer_real();
+                    run_batch(fn, n);
+                    double elapsed = mu_timer_real() - start;
+                    samples[r] = elapsed * 1e9 / n;
+                    total += elapsed;
+                }
+                qsort(samples, reps, sizeof(double), compare_doubles);
+                double ns_per_op = total * 1e9 / ((double) reps * n);
+                double p50 = samples[reps / 2];
+                double p90 = samples[(int) (reps * 0.9)];
+                double p99 = samples[(int) (reps * 0.99)];
+                printf("%-20s %-12s %6d %10.2f %14.0f %10.2f %10.2f %10.2f\n",
+                       fn_names[fn], mix_names[mix], n, ns_per_op,
+                       1e9 / ns_per_op, p50, p90, p99);
+                if (csv) {
+                    fprintf(csv, "%s,%s,%d,%d,%.3f,%.0f,%.3f,%.3f,%.3f\n",
+                            fn_names[fn], mix_names[mix], n, reps, ns_per_op,
+                            1e9 / ns_per_op, p50, p90, p99);
+                }
+            }
+        }
+    }
+    if (csv) {
+        fclose(csv);
+    }
+    return 0;
+}
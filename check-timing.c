@@ -24,24 +24,31 @@
 ///      gcc -lm -static-libgcc -c check-timing.c ramp.c tests.c
 ///      gcc -shared -lm -static-libgcc -o timing-labview.dll check-timing.o ramp.o tests.o
 
-/// TODO:
-/// Define a function to get an error message from the status.
-
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <tgmath.h>
 #include "check-timing.h"
+#include "instrument.h"
+#include "simd.h"
 
 /// Initialize a TimingParameter on the heap.
 void* TP_init(double fs, double dt, double N, double T) {
     TimingParameter* tp = malloc(sizeof(TimingParameter));
+    TP_init_inplace(tp, fs, dt, N, T);
+    return tp;
+}
+
+/// Initialize a TimingParameter owned by the caller (on the stack, in a
+/// ParameterPool, or in a LabView cluster) without allocating.
+void TP_init_inplace(TimingParameter* tp, double fs, double dt, double N,
+                     double T) {
     tp->fs = fs;
     tp->dt = dt;
     tp->N = N;
     tp->T = T;
     tp->eps = 0.1; // Default to 0.1 for eps; used to determine if a
                    // TimingParameter is internally consistant.
-    return tp;
 }
 
 // A helper function to print a TimingParameter
@@ -66,26 +73,31 @@ int fs_dt_consistent(TimingParameter *tp) {
             // Since fs is what is sent to the DAQ, we'll define dt in terms
             // of fs.
             tp->dt = 1.0 / tp->fs; 
+            TI_FS_DT(TI_FS_DT_AGREE);
         }
         else {
              // Timing parameters don't match. Leave the situation to be
             // cleaned up by the next function, or define dt in terms of fs?.
             status = 1;
             tp->dt = 1.0 / tp->fs;
+            TI_FS_DT(TI_FS_DT_DISAGREE);
         }
     }
     else if (fs_defined && !dt_defined) {
         // fs defined
         tp->dt = 1.0 / tp->fs;
+        TI_FS_DT(TI_FS_ONLY);
     }
     else if (!fs_defined && dt_defined) {
         // dt defined
         tp->fs = 1.0 / tp->dt;
+        TI_FS_DT(TI_DT_ONLY);
     }
     else if (!fs_defined && !dt_defined) {
         // Neither defined. Exit with status 2, and let N_T consistent deal
         // with this.
         status = 2;
+        TI_FS_DT(TI_FS_DT_NEITHER);
     }
     return status;
 }
@@ -107,38 +119,46 @@ int N_T_consistent(TimingParameter *tp) {
             // dt in terms of fs.
             tp->fs = tp->N / tp->T;
             tp->dt = 1.0 / tp->fs;
+            TI_N_T(TI_NT_FS_FROM_N_T);
         }
         else if (fs_defined && dt_defined) {
             // This is complicated, but things are all defined, so just raise
             // a status and get out. Should probably have a function to check 
             // the cluster's consistency here.
             status = 3;
+            TI_N_T(TI_NT_OVERDEFINED);
         }
         else {
             // The structure should not get into this state. Just raise a
             // status and get out.
             status = -2;
+            TI_N_T(TI_NT_INCONSISTENT);
         }
     } else if (N_defined && !T_defined) {
         // Assume fs and dt are already defined. We default to always using fs
         if (fs_defined && dt_defined) {
             tp->T = tp->N / tp->fs;
+            TI_N_T(TI_NT_T_FROM_N);
         }
         else {
             // Again, this is not a well-defined state for TP.
             status = -1;
+            TI_N_T(TI_NT_N_NO_RATE);
         }
     } else if (!N_defined && T_defined) {
         if (fs_defined && dt_defined) {
             tp->N = floor(tp->T * tp->fs + 0.5);
+            TI_N_T(TI_NT_N_FROM_T);
         }
         else {
             // Again, this is not a well-defined state for TP.
             status = -1;
+            TI_N_T(TI_NT_T_NO_RATE);
         }
     } else if (!N_defined && !T_defined){
         // Not enough parameters defined; raise a real error
         status = -1;
+        TI_N_T(TI_NT_NOTHING);
     }
     return status;
 }
@@ -148,12 +168,522 @@ int N_T_consistent(TimingParameter *tp) {
 // a self-consistent state, or have raised an error by returning a status < 0.
 int TP_check(TimingParameter* tp) {
     int status;
+    TI_START(start);
     status = fs_dt_consistent(tp);
     // Ignoring the first status; only used for debugging currently.
     status = N_T_consistent(tp);
+    TI_STATUS(status);
+    TI_TP_LATENCY(start);
     return status;
 }
 
+// Scalar batch loop; used for the tail of the vector kernels and on targets
+// without them.
+static int TP_check_batch_scalar(double* fs, double* dt, double* N, double* T,
+                                 const double* eps, int* status, size_t n) {
+    int n_errors = 0;
+    for (size_t i = 0; i < n; i++) {
+        TimingParameter tp = {fs[i], dt[i], N[i], T[i], eps[i]};
+        status[i] = TP_check(&tp);
+        fs[i] = tp.fs;
+        dt[i] = tp.dt;
+        N[i] = tp.N;
+        T[i] = tp.T;
+        n_errors += status[i] < 0;
+    }
+    return n_errors;
+}
+
+#ifdef TIMING_SIMD_X86
+// Branchless versions of fs_dt_consistent followed by N_T_consistent. Every
+// case is computed in every lane and the results are chosen with masks, so
+// the operations (and therefore the rounding) are the same as in the scalar
+// code. eps is not needed: it only decides the status of fs_dt_consistent,
+// which TP_check discards, and dt is set to 1 / fs either way.
+// Both kernels return the number of elements they handled; the caller
+// finishes the remainder with the scalar loop.
+
+static inline __m128d sel_sse2(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+// floor for 0 <= x; adding and subtracting 2^52 rounds to an integer.
+static inline __m128d floor_sse2(__m128d x) {
+    const __m128d two52 = _mm_set1_pd(4503599627370496.0);
+    __m128d r = _mm_sub_pd(_mm_add_pd(x, two52), two52);
+    r = _mm_sub_pd(r, _mm_and_pd(_mm_cmpgt_pd(r, x), _mm_set1_pd(1.0)));
+    return sel_sse2(_mm_cmplt_pd(x, two52), r, x);
+}
+
+static size_t TP_check_batch_sse2(double* fs, double* dt, double* N, double* T,
+                                  int* status, size_t n) {
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d all = _mm_cmpeq_pd(zero, zero);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d vfs = _mm_loadu_pd(fs + i);
+        __m128d vdt = _mm_loadu_pd(dt + i);
+        __m128d vN = _mm_loadu_pd(N + i);
+        __m128d vT = _mm_loadu_pd(T + i);
+
+        // fs_dt_consistent
+        __m128d fs_defined = _mm_cmpgt_pd(vfs, zero);
+        __m128d dt_defined = _mm_cmpgt_pd(vdt, zero);
+        __m128d dt_only = _mm_andnot_pd(fs_defined, dt_defined);
+        __m128d dt1 = sel_sse2(fs_defined, _mm_div_pd(one, vfs), vdt);
+        __m128d fs1 = sel_sse2(dt_only, _mm_div_pd(one, vdt), vfs);
+
+        // N_T_consistent
+        fs_defined = _mm_cmpgt_pd(fs1, zero);
+        dt_defined = _mm_cmpgt_pd(dt1, zero);
+        __m128d N_defined = _mm_cmpgt_pd(vN, zero);
+        __m128d T_defined = _mm_cmpgt_pd(vT, zero);
+        __m128d both = _mm_and_pd(fs_defined, dt_defined);
+        __m128d neither = _mm_andnot_pd(_mm_or_pd(fs_defined, dt_defined), all);
+        __m128d N_T = _mm_and_pd(N_defined, T_defined);
+        __m128d N_only = _mm_andnot_pd(T_defined, N_defined);
+        __m128d T_only = _mm_andnot_pd(N_defined, T_defined);
+
+        __m128d fs_N_T = _mm_div_pd(vN, vT);
+        __m128d case_N_T = _mm_and_pd(N_T, neither);
+        __m128d case_N = _mm_and_pd(N_only, both);
+        __m128d case_T = _mm_and_pd(T_only, both);
+        __m128d fs2 = sel_sse2(case_N_T, fs_N_T, fs1);
+        __m128d dt2 = sel_sse2(case_N_T, _mm_div_pd(one, fs_N_T), dt1);
+        __m128d T2 = sel_sse2(case_N, _mm_div_pd(vN, fs1), vT);
+        __m128d N2 = sel_sse2(case_T,
+            floor_sse2(_mm_add_pd(_mm_mul_pd(vT, fs1), half)), vN);
+
+        __m128d ok = _mm_or_pd(case_N_T, _mm_or_pd(case_N, case_T));
+        __m128d st = sel_sse2(N_T, _mm_set1_pd(-2.0), _mm_set1_pd(-1.0));
+        st = sel_sse2(_mm_and_pd(N_T, both), _mm_set1_pd(3.0), st);
+        st = sel_sse2(ok, zero, st);
+
+        _mm_storeu_pd(fs + i, fs2);
+        _mm_storeu_pd(dt + i, dt2);
+        _mm_storeu_pd(N + i, N2);
+        _mm_storeu_pd(T + i, T2);
+        _mm_storel_epi64((__m128i*) (status + i), _mm_cvttpd_epi32(st));
+    }
+    return i;
+}
+
+TIMING_TARGET_AVX2
+static size_t TP_check_batch_avx2(double* fs, double* dt, double* N, double* T,
+                                  int* status, size_t n) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vfs = _mm256_loadu_pd(fs + i);
+        __m256d vdt = _mm256_loadu_pd(dt + i);
+        __m256d vN = _mm256_loadu_pd(N + i);
+        __m256d vT = _mm256_loadu_pd(T + i);
+
+        // fs_dt_consistent
+        __m256d fs_defined = _mm256_cmp_pd(vfs, zero, _CMP_GT_OQ);
+        __m256d dt_defined = _mm256_cmp_pd(vdt, zero, _CMP_GT_OQ);
+        __m256d dt_only = _mm256_andnot_pd(fs_defined, dt_defined);
+        __m256d dt1 = _mm256_blendv_pd(vdt, _mm256_div_pd(one, vfs), fs_defined);
+        __m256d fs1 = _mm256_blendv_pd(vfs, _mm256_div_pd(one, vdt), dt_only);
+
+        // N_T_consistent
+        fs_defined = _mm256_cmp_pd(fs1, zero, _CMP_GT_OQ);
+        dt_defined = _mm256_cmp_pd(dt1, zero, _CMP_GT_OQ);
+        __m256d N_defined = _mm256_cmp_pd(vN, zero, _CMP_GT_OQ);
+        __m256d T_defined = _mm256_cmp_pd(vT, zero, _CMP_GT_OQ);
+        __m256d both = _mm256_and_pd(fs_defined, dt_defined);
+        __m256d either = _mm256_or_pd(fs_defined, dt_defined);
+        __m256d N_T = _mm256_and_pd(N_defined, T_defined);
+        __m256d N_only = _mm256_andnot_pd(T_defined, N_defined);
+        __m256d T_only = _mm256_andnot_pd(N_defined, T_defined);
+
+        __m256d fs_N_T = _mm256_div_pd(vN, vT);
+        __m256d case_N_T = _mm256_andnot_pd(either, N_T);
+        __m256d case_N = _mm256_and_pd(N_only, both);
+        __m256d case_T = _mm256_and_pd(T_only, both);
+        __m256d fs2 = _mm256_blendv_pd(fs1, fs_N_T, case_N_T);
+        __m256d dt2 = _mm256_blendv_pd(dt1, _mm256_div_pd(one, fs_N_T), case_N_T);
+        __m256d T2 = _mm256_blendv_pd(vT, _mm256_div_pd(vN, fs1), case_N);
+        __m256d N2 = _mm256_blendv_pd(vN,
+            _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(vT, fs1), half)), case_T);
+
+        __m256d ok = _mm256_or_pd(case_N_T, _mm256_or_pd(case_N, case_T));
+        __m256d st = _mm256_blendv_pd(_mm256_set1_pd(-1.0), _mm256_set1_pd(-2.0), N_T);
+        st = _mm256_blendv_pd(st, _mm256_set1_pd(3.0), _mm256_and_pd(N_T, both));
+        st = _mm256_blendv_pd(st, zero, ok);
+
+        _mm256_storeu_pd(fs + i, fs2);
+        _mm256_storeu_pd(dt + i, dt2);
+        _mm256_storeu_pd(N + i, N2);
+        _mm256_storeu_pd(T + i, T2);
+        _mm_storeu_si128((__m128i*) (status + i), _mm256_cvttpd_epi32(st));
+    }
+    return i;
+}
+#endif
+
+// Resolve n TimingParameters stored as separate arrays (structure of arrays).
+// Element i of fs, dt, N and T is updated in place exactly as TP_check would
+// update the corresponding TimingParameter, and its status is stored in
+// status[i]. Nothing is allocated, so a whole sweep can be passed from
+// LabView in one call. The SSE2 or AVX2 kernel is used when the CPU has it
+// (see simd.h). Returns the number of elements with a status < 0.
+int TP_check_batch(double* fs, double* dt, double* N, double* T,
+                   const double* eps, int* status, size_t n) {
+    size_t done = 0;
+    int n_errors = 0;
+#ifdef TIMING_SIMD_X86
+    int level = simd_level();
+    if (level == SIMD_AVX2) {
+        done = TP_check_batch_avx2(fs, dt, N, T, status, n);
+    }
+    else if (level == SIMD_SSE2) {
+        done = TP_check_batch_sse2(fs, dt, N, T, status, n);
+    }
+    for (size_t i = 0; i < done; i++) {
+        n_errors += status[i] < 0;
+        TI_STATUS(status[i]);
+    }
+#endif
+    n_errors += TP_check_batch_scalar(fs + done, dt + done, N + done, T + done,
+                                      eps + done, status + done, n - done);
+    return n_errors;
+}
+
+// Which of fs, dt, N and T are defined (> 0), as TP_PATTERN_* bits.
+unsigned TP_pattern(double fs, double dt, double N, double T) {
+    return (fs > 0) * TP_PATTERN_FS | (dt > 0) * TP_PATTERN_DT
+           | (N > 0) * TP_PATTERN_N | (T > 0) * TP_PATTERN_T;
+}
+
+// OR of TP_pattern(element) ^ pattern over a block, written with 64 bit
+// selects so that gcc vectorizes the AVX2 instantiation.
+#define PATTERN_DIFFERS(name, attributes)                                     \
+    TIMING_NO_TRAPS attributes                                                \
+    static uint64_t name(const double* fs, const double* dt, const double* N, \
+                         const double* T, size_t n, uint64_t pattern) {      \
+        uint64_t differ = 0;                                                  \
+        for (size_t i = 0; i < n; i++) {                                      \
+            uint64_t p = (fs[i] > 0 ? TP_PATTERN_FS : 0)                      \
+                         | (dt[i] > 0 ? TP_PATTERN_DT : 0)                    \
+                         | (N[i] > 0 ? TP_PATTERN_N : 0)                      \
+                         | (T[i] > 0 ? TP_PATTERN_T : 0);                     \
+            differ |= p ^ pattern;                                            \
+        }                                                                     \
+        return differ;                                                        \
+    }
+
+PATTERN_DIFFERS(pattern_differs_generic, )
+#ifdef TIMING_SIMD_X86
+PATTERN_DIFFERS(pattern_differs_avx2, TIMING_TARGET_AVX2)
+#endif
+
+// The pattern shared by every element of a batch, or TP_PATTERN_MIXED.
+// Mixed batches are usually found in the first block.
+unsigned TP_batch_pattern(const double* fs, const double* dt, const double* N,
+                          const double* T, size_t n) {
+    const size_t block = 512;
+    if (n == 0) {
+        return TP_PATTERN_MIXED;
+    }
+    unsigned first = TP_pattern(fs[0], dt[0], N[0], T[0]);
+    uint64_t (*differs)(const double*, const double*, const double*,
+                        const double*, size_t, uint64_t);
+    differs = pattern_differs_generic;
+#ifdef TIMING_SIMD_X86
+    if (simd_level() == SIMD_AVX2) {
+        differs = pattern_differs_avx2;
+    }
+#endif
+    for (size_t i = 0; i < n; i += block) {
+        size_t m = n - i < block ? n - i : block;
+        if (differs(fs + i, dt + i, N + i, T + i, m, first)) {
+            return TP_PATTERN_MIXED;
+        }
+    }
+    return first;
+}
+
+// Resolvers for batches in which every element defines the same two fields.
+// Knowing the pattern fixes the path through fs_dt_consistent and
+// N_T_consistent, so each loop body below is that path written out as
+// straight-line code. The only thing left to test is whether the reciprocal
+// taken in fs_dt_consistent is still > 0 (it is not for fs or dt = inf),
+// which N_T_consistent re-checks; that is a select, not a branch. The
+// operations are the ones TP_check performs, so the results are
+// bit-identical.
+//
+// TP_FIXED_LOOP(name, attributes, body) defines the loop for one pattern;
+// body updates f, d, n and t and sets st to the status. TP_FIXED_PATTERN
+// instantiates it for the generic target and, on x86-64, for AVX2, and
+// defines the public entry point that picks between them. gcc vectorizes the
+// AVX2 loops completely; on plain SSE2 it can't convert the statuses to int
+// two at a time, so the generic loops stay scalar (but without branches).
+// TIMING_NO_TRAPS lets gcc evaluate both sides of the selects and vectorize
+// floor; nothing here reads the floating point exception flags.
+#define TP_FIXED_LOOP(name, attributes, body)                                 \
+    TIMING_NO_TRAPS attributes                                                \
+    static void name(double* fs, double* dt, double* N, double* T,           \
+                     int* status, size_t n_elements) {                       \
+        for (size_t i = 0; i < n_elements; i++) {                             \
+            double f = fs[i], d = dt[i], n = N[i], t = T[i];                  \
+            double st;                                                        \
+            body                                                              \
+            fs[i] = f;                                                        \
+            dt[i] = d;                                                        \
+            N[i] = n;                                                         \
+            T[i] = t;                                                         \
+            status[i] = (int) st;                                             \
+        }                                                                     \
+    }
+
+#ifdef TIMING_SIMD_X86
+#define TP_FIXED_PATTERN(pattern, body)                                       \
+    TP_FIXED_LOOP(pattern##_generic, , body)                                  \
+    TP_FIXED_LOOP(pattern##_avx2, TIMING_TARGET_AVX2, body)                   \
+    int TP_check_batch_##pattern(double* fs, double* dt, double* N,           \
+                                 double* T, int* status, size_t n) {          \
+        if (simd_level() == SIMD_AVX2) {                                      \
+            pattern##_avx2(fs, dt, N, T, status, n);                          \
+        }                                                                     \
+        else {                                                                \
+            pattern##_generic(fs, dt, N, T, status, n);                       \
+        }                                                                     \
+        return count_errors(status, n);                                       \
+    }
+#else
+#define TP_FIXED_PATTERN(pattern, body)                                       \
+    TP_FIXED_LOOP(pattern##_generic, , body)                                  \
+    int TP_check_batch_##pattern(double* fs, double* dt, double* N,           \
+                                 double* T, int* status, size_t n) {          \
+        pattern##_generic(fs, dt, N, T, status, n);                           \
+        return count_errors(status, n);                                       \
+    }
+#endif
+
+static int count_errors(const int* status, size_t n) {
+    int n_errors = 0;
+    for (size_t i = 0; i < n; i++) {
+        n_errors += status[i] < 0;
+    }
+    return n_errors;
+}
+
+TP_FIXED_PATTERN(fs_N,
+    d = 1.0 / f;
+    double T_from_N = n / f;
+    t = d > 0 ? T_from_N : t;
+    st = d > 0 ? 0.0 : -1.0;)
+
+TP_FIXED_PATTERN(fs_T,
+    d = 1.0 / f;
+    double N_from_T = floor(t * f + 0.5);
+    n = d > 0 ? N_from_T : n;
+    st = d > 0 ? 0.0 : -1.0;)
+
+TP_FIXED_PATTERN(dt_N,
+    f = 1.0 / d;
+    double T_from_N = n / f;
+    t = f > 0 ? T_from_N : t;
+    st = f > 0 ? 0.0 : -1.0;)
+
+TP_FIXED_PATTERN(dt_T,
+    f = 1.0 / d;
+    double N_from_T = floor(t * f + 0.5);
+    n = f > 0 ? N_from_T : n;
+    st = f > 0 ? 0.0 : -1.0;)
+
+TP_FIXED_PATTERN(N_T,
+    f = n / t;
+    d = 1.0 / f;
+    st = 0;)
+
+// TP_check_batch for callers that usually send the same combination of
+// inputs. The batch's pattern is found once; if it is one of the fixed
+// patterns above, that resolver handles the whole batch, otherwise (mixed
+// batches, fs and dt both given, too few fields) TP_check_batch does.
+// Results and return value are the same as TP_check_batch.
+int TP_check_batch_fixed(double* fs, double* dt, double* N, double* T,
+                         const double* eps, int* status, size_t n) {
+    int n_errors;
+    switch (TP_batch_pattern(fs, dt, N, T, n)) {
+    case TP_PATTERN_FS | TP_PATTERN_N:
+        n_errors = TP_check_batch_fs_N(fs, dt, N, T, status, n);
+        break;
+    case TP_PATTERN_FS | TP_PATTERN_T:
+        n_errors = TP_check_batch_fs_T(fs, dt, N, T, status, n);
+        break;
+    case TP_PATTERN_DT | TP_PATTERN_N:
+        n_errors = TP_check_batch_dt_N(fs, dt, N, T, status, n);
+        break;
+    case TP_PATTERN_DT | TP_PATTERN_T:
+        n_errors = TP_check_batch_dt_T(fs, dt, N, T, status, n);
+        break;
+    case TP_PATTERN_N | TP_PATTERN_T:
+        n_errors = TP_check_batch_N_T(fs, dt, N, T, status, n);
+        break;
+    default:
+        return TP_check_batch(fs, dt, N, T, eps, status, n);
+    }
+#ifdef TIMING_INSTRUMENT
+    for (size_t i = 0; i < n; i++) {
+        TI_STATUS(status[i]);
+    }
+#endif
+    return n_errors;
+}
+
+// TIMING_ABI_VERSION of the library actually loaded, so a program can check
+// it was built against a compatible check-timing.h.
+int timing_abi_version(void) {
+    return TIMING_ABI_VERSION;
+}
+
+// Messages for the statuses of the resolvers (TP_check, TP_check_batch,
+// RP_check, ETP_check and RP_solve), indexed by status - TP_STATUS_MIN. 1 and
+// 2 are statuses of fs_dt_consistent alone, which TP_check discards, so they
+// have no message.
+static const char* const status_messages[TP_STATUS_COUNT] = {
+    "no timing satisfies the hardware limits",              // -4
+    "exact result does not fit in 64 bits",                 // -3
+    "fs or dt out of range; only one could be defined",     // -2
+    "not enough parameters: need fs or dt with N or T, "
+    "or both N and T",                                      // -1
+    "consistent",                                           //  0
+    NULL,                                                   //  1
+    NULL,                                                   //  2
+    "fs, dt, N and T all defined; left unchanged",          //  3
+};
+
+/// A short description of a status returned by one of the resolvers:
+/// TP_check, TP_check_batch, RP_check, ETP_check (ETP_OVERFLOW) or RP_solve
+/// (SOLVE_INFEASIBLE). The string is static. Other statuses, including the
+/// -1 that fill and setup functions return for bad arguments, are not
+/// described: anything the resolvers never return gets "unknown status".
+const char* TP_status_message(int status) {
+    unsigned k = (unsigned) status - (unsigned) TP_STATUS_MIN;
+    if (k >= TP_STATUS_COUNT || status_messages[k] == NULL) {
+        return "unknown status";
+    }
+    return status_messages[k];
+}
+
+/// Count the statuses of a batch (as written by TP_check_batch) into diag,
+/// recording where each status first occurs. Nothing is formatted; pass diag
+/// to TP_diagnostic_text for a report. Returns the number of errors.
+size_t TP_diagnose(const int* status, size_t n, TimingDiagnostic* diag) {
+    size_t count[TP_STATUS_COUNT] = {0};
+    size_t n_unknown = 0;
+    size_t n_errors = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned k = (unsigned) status[i] - (unsigned) TP_STATUS_MIN;
+        if (k < TP_STATUS_COUNT) {
+            count[k]++;
+        }
+        else {
+            n_unknown++;
+            n_errors += status[i] < 0;
+        }
+    }
+    for (int k = 0; k < TP_STATUS_COUNT; k++) {
+        if (status_messages[k] == NULL) {
+            n_unknown += count[k];
+            count[k] = 0;
+        }
+    }
+    diag->n = n;
+    diag->n_errors = n_errors;
+    diag->n_unknown = n_unknown;
+    for (int k = 0; k < TP_STATUS_COUNT; k++) {
+        diag->count[k] = count[k];
+        diag->first[k] = n;
+        if (k + TP_STATUS_MIN < 0) {
+            diag->n_errors += count[k];
+        }
+    }
+    // Second pass for the first occurrences, stopping once all are found.
+    int missing = 0;
+    for (int k = 0; k < TP_STATUS_COUNT; k++) {
+        missing += count[k] > 0;
+    }
+    for (size_t i = 0; i < n && missing > 0; i++) {
+        unsigned k = (unsigned) status[i] - (unsigned) TP_STATUS_MIN;
+        if (k < TP_STATUS_COUNT && diag->count[k] > 0 && diag->first[k] == n) {
+            diag->first[k] = i;
+            missing--;
+        }
+    }
+    return diag->n_errors;
+}
+
+// Append str to buf at *len, keeping at most size - 1 characters; *len keeps
+// counting past the end so the caller learns the size needed.
+static void append(char* buf, size_t size, size_t* len, const char* str) {
+    for (; *str; str++, (*len)++) {
+        if (*len + 1 < size) {
+            buf[*len] = *str;
+        }
+    }
+}
+
+static void append_size(char* buf, size_t size, size_t* len, size_t x) {
+    char digits[24];
+    char* p = digits + sizeof(digits) - 1;
+    *p = '\0';
+    do {
+        *--p = (char) ('0' + x % 10);
+        x /= 10;
+    } while (x > 0);
+    append(buf, size, len, p);
+}
+
+/// Write a report of diag into buf, one line per status present:
+///     1000 statuses, 3 errors
+///     -1: 3, first at 17: not enough parameters: ...
+///     0: 997, first at 0: consistent
+/// Formatted by hand, so it is safe and cheap to call from the LabView DLL.
+/// Like snprintf, at most size - 1 characters are written, buf is always
+/// terminated (if size > 0), and the return value is the length of the full
+/// report.
+size_t TP_diagnostic_text(const TimingDiagnostic* diag, char* buf,
+                          size_t size) {
+    size_t len = 0;
+    append_size(buf, size, &len, diag->n);
+    append(buf, size, &len, " statuses, ");
+    append_size(buf, size, &len, diag->n_errors);
+    append(buf, size, &len, diag->n_errors == 1 ? " error\n" : " errors\n");
+    for (int k = 0; k < TP_STATUS_COUNT; k++) {
+        if (diag->count[k] == 0) {
+            continue;
+        }
+        int status = k + TP_STATUS_MIN;
+        if (status < 0) {
+            append(buf, size, &len, "-");
+        }
+        append_size(buf, size, &len, (size_t) abs(status));
+        append(buf, size, &len, ": ");
+        append_size(buf, size, &len, diag->count[k]);
+        append(buf, size, &len, ", first at ");
+        append_size(buf, size, &len, diag->first[k]);
+        append(buf, size, &len, ": ");
+        append(buf, size, &len, status_messages[k]);
+        append(buf, size, &len, "\n");
+    }
+    if (diag->n_unknown > 0) {
+        append(buf, size, &len, "unknown: ");
+        append_size(buf, size, &len, diag->n_unknown);
+        append(buf, size, &len, "\n");
+    }
+    if (size > 0) {
+        buf[len < size ? len : size - 1] = '\0';
+    }
+    return len;
+}
+
 // A helper function to debug TimingParameter by printing.
 // Replaced by minunit unittests, but could still be useful for adding
 // functionality.
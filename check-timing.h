@@ -4,6 +4,20 @@
 #ifndef __CHECKTIMING_H__
 #define __CHECKTIMING_H__
 
+#include <stddef.h>
+
+// Functions marked TIMING_API make up the ABI of the Linux shared library
+// (make shared), which is built with -fvisibility=hidden. Bump
+// TIMING_ABI_VERSION, and the library's major version with it, whenever one
+// of them or a structure they take changes incompatibly.
+#define TIMING_ABI_VERSION 1
+
+#if defined(__GNUC__) && !defined(_WIN32)
+#define TIMING_API __attribute__((visibility("default")))
+#else
+#define TIMING_API
+#endif
+
 typedef struct TimingParameters {
     double fs;
     double dt;
@@ -14,11 +28,77 @@ typedef struct TimingParameters {
 
 void* TP_init(double fs, double dt, double N, double T);
 
-int fs_dt_consistent(TimingParameter *tp);
+TIMING_API void TP_init_inplace(TimingParameter* tp, double fs, double dt,
+                                double N, double T);
+
+TIMING_API int fs_dt_consistent(TimingParameter *tp);
+
+TIMING_API int N_T_consistent(TimingParameter *tp);
+
+TIMING_API int TP_check(TimingParameter* tp);
+
+TIMING_API int TP_check_batch(double* fs, double* dt, double* N, double* T,
+                              const double* eps, int* status, size_t n);
+
+// Which fields a TimingParameter defines (see TP_pattern).
+#define TP_PATTERN_FS    0x1
+#define TP_PATTERN_DT    0x2
+#define TP_PATTERN_N     0x4
+#define TP_PATTERN_T     0x8
+#define TP_PATTERN_MIXED 0x10   // Elements of a batch differ.
+
+TIMING_API unsigned TP_pattern(double fs, double dt, double N, double T);
+
+TIMING_API unsigned TP_batch_pattern(const double* fs, const double* dt,
+                                     const double* N, const double* T,
+                                     size_t n);
+
+// Batch resolvers for a single pattern; every element must define exactly the
+// fields in the name.
+TIMING_API int TP_check_batch_fs_N(double* fs, double* dt, double* N,
+                                   double* T, int* status, size_t n);
+
+TIMING_API int TP_check_batch_fs_T(double* fs, double* dt, double* N,
+                                   double* T, int* status, size_t n);
+
+TIMING_API int TP_check_batch_dt_N(double* fs, double* dt, double* N,
+                                   double* T, int* status, size_t n);
+
+TIMING_API int TP_check_batch_dt_T(double* fs, double* dt, double* N,
+                                   double* T, int* status, size_t n);
+
+TIMING_API int TP_check_batch_N_T(double* fs, double* dt, double* N, double* T,
+                                  int* status, size_t n);
+
+TIMING_API int TP_check_batch_fixed(double* fs, double* dt, double* N,
+                                    double* T, const double* eps, int* status,
+                                    size_t n);
+
+// Range of the statuses of the resolvers described by TP_status_message:
+// TP_check's -2 to 3, plus ETP_OVERFLOW (-3, exact-timing.h) and
+// SOLVE_INFEASIBLE (-4, solve.h), which assert they match.
+#define TP_STATUS_MIN   -4
+#define TP_STATUS_MAX   3
+#define TP_STATUS_COUNT (TP_STATUS_MAX - TP_STATUS_MIN + 1)
+
+// Summary of the statuses of a batch (see TP_diagnose).
+typedef struct TimingDiagnostics {
+    size_t n;                       // Statuses summarized.
+    size_t n_errors;                // Statuses < 0.
+    size_t n_unknown;               // Statuses with no message.
+    size_t count[TP_STATUS_COUNT];  // Indexed by status - TP_STATUS_MIN.
+    size_t first[TP_STATUS_COUNT];  // Index of the first such status, or n.
+} TimingDiagnostic;
+
+TIMING_API const char* TP_status_message(int status);
+
+TIMING_API size_t TP_diagnose(const int* status, size_t n,
+                              TimingDiagnostic* diag);
 
-int N_T_consistent(TimingParameter *tp);
+TIMING_API size_t TP_diagnostic_text(const TimingDiagnostic* diag, char* buf,
+                                     size_t size);
 
-int TP_check(TimingParameter* tp);
+TIMING_API int timing_abi_version(void);
 
 int check_tp_case(TimingParameter* tp, char message[]);
 
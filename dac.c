@@ -0,0 +1,185 @@
+/// dac.c
+/// Plan and generate ramps directly in DAC codes.
+///
+/// A DAC can only output vmin + k * lsb for k = 0 .. 2^bits - 1, so a ramp
+/// planned in volts alone wastes samples: a dy below one LSB repeats codes.
+/// RP_check_dac snaps the ramp to code boundaries and keeps N no larger than
+/// the number of codes the ramp crosses, so each sample is a new code. The
+/// ramp is then written straight into int16 or int32 code buffers (2 or 4
+/// bytes a sample instead of 8 for doubles) by the same vectorized
+/// y * scale + offset conversion RP_fill uses.
+
+#include <tgmath.h>
+#include "dac.h"
+#include "simd.h"
+
+/// Describe a DAC with the given resolution whose codes code_min ..
+/// code_min + 2^bits - 1 output vmin .. vmax.
+/// Returns 0, or -1 if bits is not 1 to 32, vmax <= vmin, or the codes
+/// don't fit in an int32.
+int DAC_init(DacSpec* dac, int bits, double vmin, double vmax,
+             int64_t code_min) {
+    if (bits < 1 || bits > 32 || !(vmax > vmin)
+        || !isfinite(vmin) || !isfinite(vmax)) {
+        return -1;
+    }
+    int64_t code_max = code_min + (int64_t) ((1ULL << bits) - 1);
+    if (code_min < INT32_MIN || code_max > INT32_MAX) {
+        return -1;
+    }
+    dac->bits = bits;
+    dac->vmin = vmin;
+    dac->vmax = vmax;
+    dac->code_min = (int32_t) code_min;
+    dac->code_max = (int32_t) code_max;
+    dac->lsb = (vmax - vmin) / (double) ((1ULL << bits) - 1);
+    dac->scale = 1.0 / dac->lsb;
+    dac->offset = (double) code_min - vmin * dac->scale;
+    return 0;
+}
+
+/// The output level nearest y, clamped to vmin .. vmax.
+double DAC_snap(const DacSpec* dac, double y) {
+    double k = floor((y - dac->vmin) / dac->lsb + 0.5);
+    double k_max = (double) dac->code_max - (double) dac->code_min;
+    if (!(k > 0)) {
+        return dac->vmin;
+    }
+    if (k >= k_max) {
+        return dac->vmax;
+    }
+    return dac->vmin + k * dac->lsb;
+}
+
+// Conversion shared by DAC_code and the fills: round to nearest (ties to
+// even, as the SIMD conversions do) and clamp to the DAC's codes.
+static inline int32_t dac_code(double y, double scale, double offset,
+                               double lo, double hi) {
+    double c = y * scale + offset;
+    c = c > lo ? c : lo;
+    c = c < hi ? c : hi;
+    return (int32_t) lrint(c);
+}
+
+/// The code that outputs the level nearest y.
+int32_t DAC_code(const DacSpec* dac, double y) {
+    return dac_code(y, dac->scale, dac->offset, dac->code_min, dac->code_max);
+}
+
+/// RP_check for a ramp output by dac. yi and yf are first snapped to output
+/// levels and dy (if given) to a whole number of LSBs, at least one. If the
+/// resolved ramp has more samples than the codes from yi to yf, so some
+/// codes would repeat, N is lowered to that number of codes and fs lowered
+/// to keep T. rp is updated in place. Returns the status of RP_check.
+int RP_check_dac(RampParameter* rp, TimingParameter* tp, const DacSpec* dac) {
+    rp->yi = DAC_snap(dac, rp->yi);
+    rp->yf = DAC_snap(dac, rp->yf);
+    if (rp->dy > 0) {
+        rp->dy = fmax(floor(rp->dy / dac->lsb + 0.5), 1) * dac->lsb;
+    }
+    int status = RP_check(rp, tp);
+    double n_codes = fabs((double) DAC_code(dac, rp->yf)
+                          - (double) DAC_code(dac, rp->yi)) + 1;
+    if (status == 0 && n_codes >= 2 && tp->N > n_codes) {
+        tp->fs = 0;
+        tp->dt = 0;
+        tp->N = n_codes;
+        status = TP_check(tp);
+    }
+    return status;
+}
+
+/// Write the tp->N codes of the ramp rp into an int16 buffer of capacity
+/// len; call RP_check_dac first. Returns 0, or -1 if the DAC's codes don't
+/// fit in an int16 or tp->N is not a whole number >= 2 or exceeds len.
+int RP_fill_dac16(RampParameter* rp, TimingParameter* tp, const DacSpec* dac,
+                  int16_t* codes, size_t len) {
+    if (dac->code_min < INT16_MIN || dac->code_max > INT16_MAX) {
+        return -1;
+    }
+    // The ramp lies between two output levels, so clamping to the int16
+    // range in RP_fill is the same as clamping to the DAC's codes.
+    return RP_fill(rp, tp, NULL, codes, dac->scale, dac->offset, len);
+}
+
+#ifdef TIMING_SIMD_X86
+// Vector fills of codes 0 .. count - 1; they return how many codes were
+// written and leave the remainder to the scalar loop.
+static size_t dac_fill32_sse2(double yi, double step, size_t count,
+                              int32_t* codes, double scale, double offset,
+                              double lo, double hi) {
+    const __m128d vyi = _mm_set1_pd(yi);
+    const __m128d vstep = _mm_set1_pd(step);
+    const __m128d vscale = _mm_set1_pd(scale);
+    const __m128d voffset = _mm_set1_pd(offset);
+    const __m128d vlo = _mm_set1_pd(lo);
+    const __m128d vhi = _mm_set1_pd(hi);
+    const __m128d two = _mm_set1_pd(2.0);
+    __m128d idx = _mm_setr_pd(0, 1);
+    size_t j = 0;
+    for (; j + 2 <= count; j += 2) {
+        __m128d v = _mm_add_pd(vyi, _mm_mul_pd(idx, vstep));
+        __m128d c = _mm_add_pd(_mm_mul_pd(v, vscale), voffset);
+        c = _mm_min_pd(_mm_max_pd(c, vlo), vhi);
+        _mm_storel_epi64((__m128i*) (codes + j), _mm_cvtpd_epi32(c));
+        idx = _mm_add_pd(idx, two);
+    }
+    return j;
+}
+
+TIMING_TARGET_AVX2
+static size_t dac_fill32_avx2(double yi, double step, size_t count,
+                              int32_t* codes, double scale, double offset,
+                              double lo, double hi) {
+    const __m256d vyi = _mm256_set1_pd(yi);
+    const __m256d vstep = _mm256_set1_pd(step);
+    const __m256d vscale = _mm256_set1_pd(scale);
+    const __m256d voffset = _mm256_set1_pd(offset);
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    const __m256d four = _mm256_set1_pd(4.0);
+    __m256d idx = _mm256_setr_pd(0, 1, 2, 3);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m256d v = _mm256_add_pd(vyi, _mm256_mul_pd(idx, vstep));
+        __m256d c = _mm256_add_pd(_mm256_mul_pd(v, vscale), voffset);
+        c = _mm256_min_pd(_mm256_max_pd(c, vlo), vhi);
+        _mm_storeu_si128((__m128i*) (codes + j), _mm256_cvtpd_epi32(c));
+        idx = _mm256_add_pd(idx, four);
+    }
+    return j;
+}
+#endif
+
+/// As RP_fill_dac16, for DACs of any resolution, into an int32 buffer.
+/// The samples are those of RP_fill. Returns 0, or -1 if tp->N is not a
+/// whole number >= 2 or exceeds len.
+int RP_fill_dac32(RampParameter* rp, TimingParameter* tp, const DacSpec* dac,
+                  int32_t* codes, size_t len) {
+    if (!(tp->N >= 2) || tp->N != floor(tp->N) || tp->N > (double) len) {
+        return -1;
+    }
+    size_t N = (size_t) tp->N;
+    double step = (rp->yf - rp->yi) / (double) (N - 1);
+    double lo = dac->code_min;
+    double hi = dac->code_max;
+    size_t j = 0;
+#ifdef TIMING_SIMD_X86
+    int level = simd_level();
+    if (level == SIMD_AVX2) {
+        j = dac_fill32_avx2(rp->yi, step, N, codes, dac->scale, dac->offset,
+                            lo, hi);
+    }
+    else if (level == SIMD_SSE2) {
+        j = dac_fill32_sse2(rp->yi, step, N, codes, dac->scale, dac->offset,
+                            lo, hi);
+    }
+#endif
+    for (; j < N; j++) {
+        codes[j] = dac_code(rp->yi + (double) j * step, dac->scale,
+                            dac->offset, lo, hi);
+    }
+    // Pin the final sample to yf, as ramp_fill_range does.
+    codes[N - 1] = dac_code(rp->yf, dac->scale, dac->offset, lo, hi);
+    return 0;
+}
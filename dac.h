@@ -0,0 +1,37 @@
+// DAC Header
+// Plan ramps in the codes of a DAC with a fixed resolution and range.
+#ifndef __DAC_H__
+#define __DAC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+typedef struct DacSpecs {
+    int bits;           // Resolution, 1 to 32.
+    double vmin;        // Output at code_min.
+    double vmax;        // Output at code_max.
+    int32_t code_min;   // e.g. -2^(bits - 1) for signed codes, 0 for offset
+    int32_t code_max;   // binary; code_max = code_min + 2^bits - 1.
+    double lsb;         // Volts per code.
+    double scale;       // code = y * scale + offset, as in RP_fill.
+    double offset;
+} DacSpec;
+
+int DAC_init(DacSpec* dac, int bits, double vmin, double vmax,
+             int64_t code_min);
+
+double DAC_snap(const DacSpec* dac, double y);
+
+int32_t DAC_code(const DacSpec* dac, double y);
+
+int RP_check_dac(RampParameter* rp, TimingParameter* tp, const DacSpec* dac);
+
+int RP_fill_dac16(RampParameter* rp, TimingParameter* tp, const DacSpec* dac,
+                  int16_t* codes, size_t len);
+
+int RP_fill_dac32(RampParameter* rp, TimingParameter* tp, const DacSpec* dac,
+                  int32_t* codes, size_t len);
+
+#endif /* __DAC_H__ */
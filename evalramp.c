@@ -1,13 +1,34 @@
 /// A main function to run RP_check
+///     evalramp yi yf dydt dy
+///     evalramp [--binary] FILE   (records of yi yf dydt dy; FILE may be -)
+/// The streaming mode writes the resolved fs dt N T and status.
 #include <stdlib.h>
 #include <stdio.h>
 #include "check-timing.h"
 #include "ramp.h"
+#include "stream-io.h"
+
+static int resolve(const double inputs[], double outputs[]) {
+    TimingParameter tp;
+    RampParameter rp;
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    RP_init_inplace(&rp, inputs[0], inputs[1], inputs[2], inputs[3]);
+    int status = RP_check(&rp, &tp);
+    outputs[0] = tp.fs;
+    outputs[1] = tp.dt;
+    outputs[2] = tp.N;
+    outputs[3] = tp.T;
+    return status;
+}
 
 int main(int argc, char const *argv[])
 {
+    if (argc == 2 || argc == 3) {
+        return stream_main(argc, argv, 4, resolve);
+    }
     if (argc < 5) {
-        printf("Please input yi yf dydt dy.\n");
+        printf("Please input yi yf dydt dy, or a file (- for stdin) with one "
+               "yi yf dydt dy record per line.\n");
     }
     else {
         double yi, yf, dydt, dy;
@@ -15,14 +36,15 @@ int main(int argc, char const *argv[])
         yf = atof(argv[2]);
         dydt = atof(argv[3]);
         dy = atof(argv[4]);
-        TimingParameter* tp = TP_init(0, 0, 0,0);
-        RampParameter* rp = RP_init(yi, yf, dydt, dy);
-        int status = RP_check(rp, tp);
-        RP_print(rp);
-        TP_print(tp);
-        printf("status: %d\n", status);
-        free(tp);
-        free(rp);
+        TimingParameter tp;
+        RampParameter rp;
+        TP_init_inplace(&tp, 0, 0, 0, 0);
+        RP_init_inplace(&rp, yi, yf, dydt, dy);
+        int status = RP_check(&rp, &tp);
+        RP_print(&rp);
+        TP_print(&tp);
+        printf("status: %d (%s)\n", status,
+               TP_status_message(status));
     }
     return 0;
 }
@@ -1,12 +1,30 @@
 /// A main function to run TP_check
+///     evaltp fs dt N T
+///     evaltp [--binary] FILE     (records of fs dt N T; FILE may be -)
 #include <stdlib.h>
 #include <stdio.h>
 #include "check-timing.h"
+#include "stream-io.h"
+
+static int resolve(const double inputs[], double outputs[]) {
+    TimingParameter tp;
+    TP_init_inplace(&tp, inputs[0], inputs[1], inputs[2], inputs[3]);
+    int status = TP_check(&tp);
+    outputs[0] = tp.fs;
+    outputs[1] = tp.dt;
+    outputs[2] = tp.N;
+    outputs[3] = tp.T;
+    return status;
+}
 
 int main(int argc, char const *argv[])
 {
+    if (argc == 2 || argc == 3) {
+        return stream_main(argc, argv, 4, resolve);
+    }
     if (argc < 5) {
-        printf("Please input fs dt N T.\n");
+        printf("Please input fs dt N T, or a file (- for stdin) with one "
+               "fs dt N T record per line.\n");
     }
     else {
         double fs, dt, N, T;
@@ -14,11 +32,12 @@ int main(int argc, char const *argv[])
         dt = atof(argv[2]);
         N = atof(argv[3]);
         T = atof(argv[4]);
-        TimingParameter* tp = TP_init(fs, dt, N, T);
-        int status = TP_check(tp);
-        TP_print(tp);
-        printf("status: %d\n", status);
-        free(tp);
+        TimingParameter tp;
+        TP_init_inplace(&tp, fs, dt, N, T);
+        int status = TP_check(&tp);
+        TP_print(&tp);
+        printf("status: %d (%s)\n", status,
+               TP_status_message(status));
     }
     return 0;
 }
@@ -0,0 +1,219 @@
+/// exact-timing.c
+/// An exact version of TP_check.
+///
+/// fs_dt_consistent and N_T_consistent work in doubles, so at high fs and long
+/// T, N = floor(T * fs + 0.5) can come out one off and dt = 1 / fs doesn't
+/// round trip. Here fs, dt and T are rationals (typically ticks of a DAQ
+/// timebase, see ETP_init_ticks) and N is a 64 bit integer. Every step uses
+/// integer arithmetic with 128 bit intermediates, so the results are exact,
+/// and no libm calls are needed. The cases and statuses mirror
+/// fs_dt_consistent and N_T_consistent, except that fs and dt must agree
+/// exactly rather than within eps, and a result that does not fit in 64 bits
+/// gives ETP_OVERFLOW.
+
+#include "exact-timing.h"
+
+// TP_status_message describes ETP_OVERFLOW as -3.
+__extension__ _Static_assert(ETP_OVERFLOW == -3 && ETP_OVERFLOW >= TP_STATUS_MIN,
+                             "ETP_OVERFLOW must match TP_status_message");
+
+__extension__ typedef __int128 int128;
+
+// Binary gcd of a and b > 0: shifts and subtractions only, with selects in
+// place of the swap so random operands don't cost branch mispredictions.
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        uint64_t lo = a < b ? a : b;
+        uint64_t hi = a < b ? b : a;
+        a = lo;
+        b = hi - lo;
+    } while (b != 0);
+    return a << shift;
+}
+
+static int128 gcd128(int128 a, int128 b) {
+    a = a < 0 ? -a : a;
+    b = b < 0 ? -b : b;
+    // Nearly every product of two int64 fields still fits in 64 bits, where
+    // the binary gcd avoids the slow 128-bit division of Euclid's algorithm.
+    if (a > 0 && b > 0 && a <= UINT64_MAX && b <= UINT64_MAX) {
+        return gcd64((uint64_t) a, (uint64_t) b);
+    }
+    while (b != 0) {
+        int128 r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Reduce num / den (den > 0) into *r. Returns 0, or ETP_OVERFLOW.
+static int reduce(int128 num, int128 den, Rational* r) {
+    int128 g = gcd128(num, den);
+    if (g > 1) {
+        if (num >= INT64_MIN && num <= INT64_MAX && den <= INT64_MAX) {
+            num = (int64_t) num / (int64_t) g;
+            den = (int64_t) den / (int64_t) g;
+        }
+        else {
+            num /= g;
+            den /= g;
+        }
+    }
+    if (num > INT64_MAX || num < INT64_MIN || den > INT64_MAX) {
+        return ETP_OVERFLOW;
+    }
+    r->num = (int64_t) num;
+    r->den = (int64_t) den;
+    return 0;
+}
+
+/// num / den in lowest terms, with the sign on the numerator. den must not
+/// be 0.
+Rational rational(int64_t num, int64_t den) {
+    Rational r = {0, 1};
+    int128 n = num;
+    int128 d = den;
+    if (d < 0) {
+        n = -n;
+        d = -d;
+    }
+    reduce(n, d, &r);
+    return r;
+}
+
+/// Describe timing in ticks of a timebase (Hz): each sample lasts
+/// ticks_per_sample ticks, and the acquisition lasts T_ticks ticks. As usual
+/// any of ticks_per_sample, N and T_ticks may be 0 for undefined.
+/// Returns 0, or -1 (leaving everything undefined) if timebase <= 0.
+int ETP_init_ticks(ExactTimingParameter* etp, int64_t timebase,
+                   int64_t ticks_per_sample, int64_t N, int64_t T_ticks) {
+    etp->fs = rational(0, 1);
+    etp->dt = rational(0, 1);
+    etp->N = 0;
+    etp->T = rational(0, 1);
+    if (timebase <= 0) {
+        return -1;
+    }
+    if (ticks_per_sample > 0) {
+        etp->dt = rational(ticks_per_sample, timebase);
+    }
+    etp->N = N;
+    if (T_ticks > 0) {
+        etp->T = rational(T_ticks, timebase);
+    }
+    return 0;
+}
+
+// 1 / r for r > 0.
+static Rational inverse(Rational r) {
+    Rational inv = {r.den, r.num};
+    return inv;
+}
+
+/// The exact counterpart of fs_dt_consistent.
+int ETP_fs_dt_consistent(ExactTimingParameter* etp) {
+    int status = 0;
+    int fs_defined = etp->fs.num > 0;
+    int dt_defined = etp->dt.num > 0;
+    if (fs_defined && dt_defined) {
+        // Both are in lowest terms, so fs * dt == 1 only if dt is exactly 1 / fs.
+        if (etp->dt.num != etp->fs.den || etp->dt.den != etp->fs.num) {
+            status = 1;
+        }
+        etp->dt = inverse(etp->fs);
+    }
+    else if (fs_defined && !dt_defined) {
+        etp->dt = inverse(etp->fs);
+    }
+    else if (!fs_defined && dt_defined) {
+        etp->fs = inverse(etp->dt);
+    }
+    else {
+        status = 2;
+    }
+    return status;
+}
+
+/// The exact counterpart of N_T_consistent.
+int ETP_N_T_consistent(ExactTimingParameter* etp) {
+    int status = 0;
+    int N_defined = etp->N > 0;
+    int T_defined = etp->T.num > 0;
+    int fs_defined = etp->fs.num > 0;
+    int dt_defined = etp->dt.num > 0;
+
+    if (N_defined && T_defined) {
+        if (!fs_defined && !dt_defined) {
+            // fs = N / T
+            status = reduce((int128) etp->N * etp->T.den, etp->T.num, &etp->fs);
+            if (status == 0) {
+                etp->dt = inverse(etp->fs);
+            }
+        }
+        else if (fs_defined && dt_defined) {
+            status = 3;
+        }
+        else {
+            status = -2;
+        }
+    }
+    else if (N_defined && !T_defined) {
+        if (fs_defined && dt_defined) {
+            // T = N / fs
+            status = reduce((int128) etp->N * etp->fs.den, etp->fs.num, &etp->T);
+        }
+        else {
+            status = -1;
+        }
+    }
+    else if (!N_defined && T_defined) {
+        if (fs_defined && dt_defined) {
+            // N = floor(T * fs + 1 / 2) = floor(a / b + 1 / 2)
+            //   = q + (2 r >= b),  a = q b + r,
+            // with a, b < 2^126, so neither 2 r nor q + 1 can overflow and
+            // only N itself has to fit in 64 bits.
+            int128 a = (int128) etp->T.num * etp->fs.num;
+            int128 b = (int128) etp->T.den * etp->fs.den;
+            int128 q;
+            if (a <= INT64_MAX && b <= INT64_MAX) {
+                q = (int64_t) a / (int64_t) b;
+            }
+            else {
+                q = a / b;
+            }
+            int128 r = a - q * b;
+            int128 N = q + (2 * r >= b);
+            if (N > INT64_MAX) {
+                return ETP_OVERFLOW;
+            }
+            etp->N = (int64_t) N;
+        }
+        else {
+            status = -1;
+        }
+    }
+    else {
+        status = -1;
+    }
+    return status;
+}
+
+/// The exact counterpart of TP_check.
+int ETP_check(ExactTimingParameter* etp) {
+    int status;
+    status = ETP_fs_dt_consistent(etp);
+    status = ETP_N_T_consistent(etp);
+    return status;
+}
+
+/// Convert to a TimingParameter (rounding each field to the nearest double).
+void ETP_to_tp(ExactTimingParameter* etp, TimingParameter* tp) {
+    tp->fs = etp->fs.num > 0 ? (double) etp->fs.num / (double) etp->fs.den : 0;
+    tp->dt = etp->dt.num > 0 ? (double) etp->dt.num / (double) etp->dt.den : 0;
+    tp->N = etp->N > 0 ? (double) etp->N : 0;
+    tp->T = etp->T.num > 0 ? (double) etp->T.num / (double) etp->T.den : 0;
+}
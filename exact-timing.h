@@ -0,0 +1,39 @@
+// Exact Timing Header
+// TimingParameter resolution in exact integer arithmetic.
+#ifndef __EXACTTIMING_H__
+#define __EXACTTIMING_H__
+
+#include <stdint.h>
+#include "check-timing.h"
+
+// num / den with den > 0, kept in lowest terms. As in TimingParameter, a
+// value <= 0 (num <= 0) means undefined.
+typedef struct Rationals {
+    int64_t num;
+    int64_t den;
+} Rational;
+
+typedef struct ExactTimingParameters {
+    Rational fs;    // Hz
+    Rational dt;    // s
+    int64_t N;
+    Rational T;     // s
+} ExactTimingParameter;
+
+// Status of ETP_check when a result does not fit in 64 bits.
+#define ETP_OVERFLOW -3
+
+Rational rational(int64_t num, int64_t den);
+
+int ETP_init_ticks(ExactTimingParameter* etp, int64_t timebase,
+                   int64_t ticks_per_sample, int64_t N, int64_t T_ticks);
+
+int ETP_fs_dt_consistent(ExactTimingParameter* etp);
+
+int ETP_N_T_consistent(ExactTimingParameter* etp);
+
+int ETP_check(ExactTimingParameter* etp);
+
+void ETP_to_tp(ExactTimingParameter* etp, TimingParameter* tp);
+
+#endif /* __EXACTTIMING_H__ */
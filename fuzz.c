@@ -0,0 +1,262 @@
+/// fuzz.c
+/// Randomized property checks for TP_check and RP_check.
+///
+/// Build and run with
+///     make fuzz
+///     ./fuzz [iterations] [seed]
+///
+/// Each input is a TimingParameter and a RampParameter. Fields are drawn
+/// from edge cases (denormals, 0, -0, inf, nan, 2^53, DBL_MAX, ...),
+/// log-uniform magnitudes, whole numbers, and fs/dt pairs straddling the eps
+/// tolerance. After resolving them the harness checks that
+///     - fs * dt = 1 and N = T * fs (to within rounding of N) when the
+///       status is 0 and the fields are finite and normal,
+///     - a fully defined result is a fixed point: a second TP_check returns
+///       3 and leaves fs, N and T bit-for-bit the same (dt may be re-derived
+///       as 1 / fs),
+///     - RP_check keeps the T and N it set from dydt and dy,
+///     - TP_check_batch and TP_check_batch_fixed give the scalar results,
+///       bit for bit, for every SIMD level.
+/// Violations are printed with the inputs in hex so they can be replayed;
+/// the exit status is the number of violations (capped at 255). The rate of
+/// inputs checked per second is printed at the end.
+///
+/// Built with TIMING_LIBFUZZER defined (make fuzz-libfuzzer, needs clang),
+/// the same checks run as a libFuzzer target instead: the fuzzer's bytes are
+/// read as records of nine doubles and any violation aborts.
+
+#include <float.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tgmath.h>
+#include <time.h>
+#include "check-timing.h"
+#include "ramp.h"
+#include "simd.h"
+
+#define FUZZ_BATCH 256
+
+typedef struct FuzzInputs {
+    double fs, dt, N, T, eps;
+    double yi, yf, dydt, dy;
+} FuzzInput;
+
+#define FUZZ_FIELDS (sizeof(FuzzInput) / sizeof(double))
+
+static unsigned long n_violations = 0;
+
+static void violation(const char* property, const FuzzInput* in) {
+    n_violations++;
+    if (n_violations <= 20) {
+        const double* x = (const double*) in;
+        fprintf(stderr, "%s:", property);
+        for (size_t i = 0; i < FUZZ_FIELDS; i++) {
+            fprintf(stderr, " %a", x[i]);
+        }
+        fprintf(stderr, "\n");
+    }
+#ifdef TIMING_LIBFUZZER
+    abort();
+#endif
+}
+
+static int same(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static int same_tp(const TimingParameter* a, const TimingParameter* b) {
+    return same(a->fs, b->fs) && same(a->dt, b->dt) && same(a->N, b->N)
+           && same(a->T, b->T);
+}
+
+static int normal(double x) {
+    return isfinite(x) && x >= DBL_MIN;
+}
+
+// Check the properties of TP_check and RP_check for one input.
+static void check_one(const FuzzInput* in) {
+    TimingParameter tp;
+    TP_init_inplace(&tp, in->fs, in->dt, in->N, in->T);
+    tp.eps = in->eps;
+    int status = TP_check(&tp);
+
+    if (status == 0 && normal(tp.fs) && normal(tp.dt) && isfinite(tp.N)
+        && isfinite(tp.T)) {
+        if (fabs(tp.fs * tp.dt - 1) > 1e-15) {
+            violation("fs * dt != 1", in);
+        }
+        double NT = tp.T * tp.fs;
+        if (isfinite(NT) && fabs(tp.N - NT) > 0.5 + 1e-12 * fabs(NT)) {
+            violation("N != T * fs", in);
+        }
+    }
+    if (status >= 0 && tp.fs > 0 && tp.dt > 0 && tp.N > 0 && tp.T > 0
+        && isfinite(tp.fs) && isfinite(tp.dt) && isfinite(tp.N)
+        && isfinite(tp.T)) {
+        // When only dt was given the first pass keeps it and sets
+        // fs = 1 / dt; the second pass then defines dt in terms of fs, which
+        // can move dt by an ulp. Everything else must stay bit for bit.
+        TimingParameter again = tp;
+        if (TP_check(&again) != 3 || !same(tp.fs, again.fs)
+            || !same(tp.N, again.N) || !same(tp.T, again.T)
+            || !(same(tp.dt, again.dt) || same(again.dt, 1.0 / tp.fs))) {
+            violation("TP_check not idempotent", in);
+        }
+    }
+
+    RampParameter rp;
+    RP_init_inplace(&rp, in->yi, in->yf, in->dydt, in->dy);
+    TP_init_inplace(&tp, in->fs, in->dt, in->N, in->T);
+    tp.eps = in->eps;
+    RP_check(&rp, &tp);
+    double y_Delta = fmax(fabs(rp.yf - rp.yi), rp.y_Delta_min);
+    if (rp.dydt > 0 && y_Delta / rp.dydt > 0 && !same(tp.T, y_Delta / rp.dydt)) {
+        violation("RP_check changed T", in);
+    }
+    if (rp.dy > 0 && !(tp.N >= 2) && !isnan(y_Delta / rp.dy)) {
+        violation("RP_check gave N < 2", in);
+    }
+}
+
+// Check that the batch resolvers agree with TP_check on n inputs.
+static void check_batch(const FuzzInput* in, size_t n) {
+    double fs[FUZZ_BATCH], dt[FUZZ_BATCH], N[FUZZ_BATCH], T[FUZZ_BATCH];
+    double eps[FUZZ_BATCH];
+    int status[FUZZ_BATCH];
+    TimingParameter expected[FUZZ_BATCH];
+    int expected_status[FUZZ_BATCH];
+    for (size_t i = 0; i < n; i++) {
+        TP_init_inplace(&expected[i], in[i].fs, in[i].dt, in[i].N, in[i].T);
+        expected[i].eps = in[i].eps;
+        expected_status[i] = TP_check(&expected[i]);
+    }
+    for (int fixed = 0; fixed < 2; fixed++) {
+        for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+            if (simd_set_level(level) != level) {
+                continue;
+            }
+            for (size_t i = 0; i < n; i++) {
+                fs[i] = in[i].fs;
+                dt[i] = in[i].dt;
+                N[i] = in[i].N;
+                T[i] = in[i].T;
+                eps[i] = in[i].eps;
+            }
+            if (fixed) {
+                TP_check_batch_fixed(fs, dt, N, T, eps, status, n);
+            }
+            else {
+                TP_check_batch(fs, dt, N, T, eps, status, n);
+            }
+            for (size_t i = 0; i < n; i++) {
+                TimingParameter got = {fs[i], dt[i], N[i], T[i], eps[i]};
+                if (status[i] != expected_status[i]
+                    || !same_tp(&got, &expected[i])) {
+                    violation(fixed ? "TP_check_batch_fixed != TP_check"
+                                    : "TP_check_batch != TP_check", &in[i]);
+                }
+            }
+        }
+    }
+    simd_set_level(-1);
+}
+
+#ifdef TIMING_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FuzzInput in[FUZZ_BATCH];
+    size_t n = size / sizeof(FuzzInput);
+    if (n > FUZZ_BATCH) {
+        n = FUZZ_BATCH;
+    }
+    memcpy(in, data, n * sizeof(FuzzInput));
+    for (size_t i = 0; i < n; i++) {
+        check_one(&in[i]);
+    }
+    check_batch(in, n);
+    return 0;
+}
+
+#else
+
+// splitmix64; rand() is far too slow to keep up with the resolver.
+static uint64_t state;
+
+static uint64_t next(void) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1).
+static double unit(void) {
+    return (double) (next() >> 11) * 0x1p-53;
+}
+
+static double field(void) {
+    static const double special[] = {
+        0, -0.0, -1, 1, 0.5, 2, 0x1p-1074, 1e-310, DBL_MIN, DBL_MAX, 1e300,
+        1e-300, 0x1p53, 0x1p53 + 2, 4503599627370495.5, 1e15, INFINITY,
+        -INFINITY, NAN
+    };
+    switch (next() % 8) {
+    case 0:
+        return 0;
+    case 1:
+    case 2:
+        return special[next() % (sizeof(special) / sizeof(special[0]))];
+    case 3:
+        // A whole number, as N usually is.
+        return floor(pow(10, 12 * unit()));
+    default:
+        return pow(10, 24 * unit() - 12);
+    }
+}
+
+static void make_input(FuzzInput* in) {
+    in->fs = field();
+    in->dt = field();
+    in->N = field();
+    in->T = field();
+    in->eps = next() % 4 ? 0.1 : field();
+    if (next() % 8 == 0) {
+        // fs and dt just inside or outside the eps tolerance.
+        double miss = in->eps * (1 + (unit() - 0.5) * 1e-9);
+        in->fs = pow(10, 6 * unit());
+        in->dt = 1 / (in->fs + (next() % 2 ? miss : -miss));
+    }
+    in->yi = next() % 4 ? 20 * unit() - 10 : field();
+    in->yf = next() % 4 ? 20 * unit() - 10 : field();
+    in->dydt = field();
+    in->dy = field();
+}
+
+int main(int argc, char const *argv[])
+{
+    double iterations = argc > 1 ? atof(argv[1]) : 1e7;
+    state = argc > 2 ? strtoull(argv[2], NULL, 0) : (uint64_t) time(NULL);
+    printf("seed %llu\n", (unsigned long long) state);
+    FuzzInput in[FUZZ_BATCH];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double done = 0;
+    while (done < iterations) {
+        for (size_t i = 0; i < FUZZ_BATCH; i++) {
+            make_input(&in[i]);
+            check_one(&in[i]);
+        }
+        check_batch(in, FUZZ_BATCH);
+        done += FUZZ_BATCH;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double) (end.tv_sec - start.tv_sec)
+                     + 1e-9 * (double) (end.tv_nsec - start.tv_nsec);
+    printf("%.0f inputs in %.2f s (%.3g per s), %lu violations\n", done,
+           seconds, done / seconds, n_violations);
+    return n_violations > 255 ? 255 : (int) n_violations;
+}
+
+#endif /* TIMING_LIBFUZZER */
@@ -0,0 +1,111 @@
+/// grid.c
+/// Cartesian sweeps such as fs in {1 kHz .. 1 MHz, log spaced} x T in {...}
+/// x dydt in {...}, described by their axes and resolved one point at a time.
+///
+/// A GridSweep never stores the product: point i is decoded from its index
+/// (the last axis added varies fastest, like nested loops), the swept fields
+/// are computed from the axis description, and the point is resolved with
+/// TP_check, or RP_check for ramp sweeps. Memory is O(number of axes) no
+/// matter how many points the grid has, and any point can be visited
+/// directly, so a front panel can page through billions of points.
+
+#include <tgmath.h>
+#include "grid.h"
+
+__extension__ _Static_assert(GRID_OUT_OF_RANGE < TP_STATUS_MIN
+                             || GRID_OUT_OF_RANGE > TP_STATUS_MAX,
+                             "GRID_OUT_OF_RANGE must not be a status");
+
+/// Start a sweep over the base parameters tp and, if rp is not NULL, rp.
+/// Fields without an axis keep their base values. With rp the points are
+/// resolved with RP_check, otherwise with TP_check.
+void GS_init(GridSweep* gs, TimingParameter* tp, RampParameter* rp) {
+    gs->tp = *tp;
+    gs->ramp = rp != NULL;
+    if (rp) {
+        gs->rp = *rp;
+    }
+    else {
+        RP_init_inplace(&gs->rp, 0, 0, 0, 0);
+    }
+    gs->n_axes = 0;
+    gs->n_points = 1;
+}
+
+/// Add an axis sweeping field (GRID_FS ... GRID_DY) over count values.
+/// Returns 0, or -1 if the axis is invalid (a ramp field in a timing-only
+/// sweep, non-positive log bounds, no values), there are already
+/// GRID_MAX_AXES axes, or the number of points would overflow 64 bits.
+int GS_add_axis(GridSweep* gs, int field, int spacing, double start,
+                double stop, const double* values, uint64_t count) {
+    if (gs->n_axes == GRID_MAX_AXES || count == 0 ||
+        field < GRID_FS || field > GRID_DY ||
+        (field >= GRID_YI && !gs->ramp) ||
+        (spacing == GRID_LOG && !(start > 0 && stop > 0)) ||
+        (spacing == GRID_LIST && values == NULL) ||
+        spacing < GRID_LINEAR || spacing > GRID_LIST ||
+        gs->n_points > UINT64_MAX / count) {
+        return -1;
+    }
+    GridAxis* axis = &gs->axes[gs->n_axes++];
+    axis->field = field;
+    axis->spacing = spacing;
+    axis->start = start;
+    axis->stop = stop;
+    axis->values = values;
+    axis->count = count;
+    gs->n_points *= count;
+    return 0;
+}
+
+// Value k of an axis; the end points are returned exactly.
+static double axis_value(GridAxis* axis, uint64_t k) {
+    if (axis->spacing == GRID_LIST) {
+        return axis->values[k];
+    }
+    if (k == 0 || axis->count == 1) {
+        return axis->start;
+    }
+    if (k == axis->count - 1) {
+        return axis->stop;
+    }
+    double u = (double) k / (double) (axis->count - 1);
+    if (axis->spacing == GRID_LOG) {
+        return axis->start * pow(axis->stop / axis->start, u);
+    }
+    return axis->start + (axis->stop - axis->start) * u;
+}
+
+/// Resolve point i (0 <= i < gs->n_points) into tp and rp, which may not be
+/// NULL. Returns the status of TP_check or RP_check, or GRID_OUT_OF_RANGE
+/// if i is out of range.
+int GS_point(GridSweep* gs, uint64_t i, TimingParameter* tp,
+             RampParameter* rp) {
+    if (i >= gs->n_points) {
+        return GRID_OUT_OF_RANGE;
+    }
+    *tp = gs->tp;
+    *rp = gs->rp;
+    double* fields[] = {&tp->fs, &tp->dt, &tp->N, &tp->T,
+                        &rp->yi, &rp->yf, &rp->dydt, &rp->dy};
+    for (int a = gs->n_axes - 1; a >= 0; a--) {
+        GridAxis* axis = &gs->axes[a];
+        *fields[axis->field] = axis_value(axis, i % axis->count);
+        i /= axis->count;
+    }
+    return gs->ramp ? RP_check(rp, tp) : TP_check(tp);
+}
+
+/// Find the first point at index >= i whose status is selected by
+/// status_mask, a combination of GS_STATUS_BIT(status) values, and resolve it
+/// into tp and rp. Returns its index, or gs->n_points if there is none.
+uint64_t GS_next(GridSweep* gs, uint64_t i, uint64_t status_mask,
+                 TimingParameter* tp, RampParameter* rp, int* status) {
+    for (; i < gs->n_points; i++) {
+        *status = GS_point(gs, i, tp, rp);
+        if (status_mask & GS_STATUS_BIT(*status)) {
+            return i;
+        }
+    }
+    return gs->n_points;
+}
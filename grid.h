@@ -0,0 +1,62 @@
+// Grid Header
+// Lazily resolved Cartesian sweeps over timing and ramp parameters.
+#ifndef __GRID_H__
+#define __GRID_H__
+
+#include <stdint.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+#define GRID_MAX_AXES 8
+
+// The field an axis sweeps.
+#define GRID_FS   0
+#define GRID_DT   1
+#define GRID_N    2
+#define GRID_T    3
+#define GRID_YI   4
+#define GRID_YF   5
+#define GRID_DYDT 6
+#define GRID_DY   7
+
+// How the values of an axis are spaced.
+#define GRID_LINEAR 0   // count values from start to stop, evenly spaced.
+#define GRID_LOG    1   // count values from start to stop, log spaced.
+#define GRID_LIST   2   // count values taken from values.
+
+typedef struct GridAxes {
+    int field;
+    int spacing;
+    double start;
+    double stop;
+    const double* values;   // GRID_LIST only; not copied.
+    uint64_t count;
+} GridAxis;
+
+typedef struct GridSweeps {
+    TimingParameter tp;     // Fields not swept by an axis.
+    RampParameter rp;
+    int ramp;               // Resolve with RP_check instead of TP_check.
+    GridAxis axes[GRID_MAX_AXES];
+    int n_axes;
+    uint64_t n_points;      // Product of the axis counts.
+} GridSweep;
+
+void GS_init(GridSweep* gs, TimingParameter* tp, RampParameter* rp);
+
+int GS_add_axis(GridSweep* gs, int field, int spacing, double start,
+                double stop, const double* values, uint64_t count);
+
+// Returned by GS_point for an index past the end of the grid; outside
+// TP_STATUS_MIN ... TP_STATUS_MAX so it is never mistaken for a status.
+#define GRID_OUT_OF_RANGE -16
+
+int GS_point(GridSweep* gs, uint64_t i, TimingParameter* tp,
+             RampParameter* rp);
+
+uint64_t GS_next(GridSweep* gs, uint64_t i, uint64_t status_mask,
+                 TimingParameter* tp, RampParameter* rp, int* status);
+
+#define GS_STATUS_BIT(status) (1ULL << ((status) + 8))
+
+#endif /* __GRID_H__ */
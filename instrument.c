@@ -0,0 +1,179 @@
+/// instrument.c
+/// Per-thread counters of which branches the resolver takes, which statuses
+/// it returns and how long it takes, for LabView to poll.
+///
+/// Each thread gets its own block of counters, aligned and padded to whole
+/// cache lines so threads never share a line, and registered once in a
+/// list. The hot path only increments its own thread's counters;
+/// TI_snapshot sums every block. When a thread exits its counts are folded
+/// into a retired total and its block is reused by the next thread, so
+/// programs that start threads over and over (TP_check_parallel does)
+/// keep as many blocks as they ever had threads alive at once.
+///
+/// Without TIMING_INSTRUMENT the hooks compile away, TI_enabled returns 0 and
+/// snapshots are all zero.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "instrument.h"
+
+/// 1 if the library was built with instrumentation.
+int TI_enabled(void) {
+#ifdef TIMING_INSTRUMENT
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+#ifdef TIMING_INSTRUMENT
+
+typedef struct InstrumentBlock InstrumentBlock;
+
+struct InstrumentBlock {
+    InstrumentCounters counters;
+    InstrumentBlock* next;      // Every block, for TI_snapshot.
+    InstrumentBlock* next_free;
+} __attribute__((aligned(64)));
+
+// blocks only grows and blocks are never freed, so the hot path never locks;
+// lock guards the free list, the retired counts and the count of blocks,
+// and makes snapshots and resets consistent with exiting threads.
+static InstrumentBlock* blocks = NULL;
+static InstrumentBlock* free_blocks = NULL;
+static InstrumentCounters retired;
+static size_t n_blocks = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+static __thread InstrumentBlock* mine = NULL;
+
+// Used if a thread's block can't be allocated; its counts are not reported.
+static __thread InstrumentBlock spare;
+
+#define N_COUNTERS (sizeof(InstrumentCounters) / sizeof(uint64_t))
+
+// Thread exit: fold the block's counts into retired and free the block.
+static void retire(void* arg) {
+    InstrumentBlock* block = arg;
+    uint64_t* sum = (uint64_t*) &retired;
+    uint64_t* c = (uint64_t*) &block->counters;
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < N_COUNTERS; i++) {
+        sum[i] += c[i];
+        __atomic_store_n(&c[i], 0, __ATOMIC_RELAXED);
+    }
+    block->next_free = free_blocks;
+    free_blocks = block;
+    pthread_mutex_unlock(&lock);
+    // Anything the thread resolves from here on is not reported.
+    mine = &spare;
+}
+
+static void make_key(void) {
+    pthread_key_create(&key, retire);
+}
+
+/// The calling thread's counters, registered on first use.
+InstrumentCounters* TI_counters(void) {
+    if (mine == NULL) {
+        pthread_once(&key_once, make_key);
+        pthread_mutex_lock(&lock);
+        InstrumentBlock* block = free_blocks;
+        if (block != NULL) {
+            free_blocks = block->next_free;
+        }
+        else if (posix_memalign((void**) &block, 64,
+                                sizeof(InstrumentBlock)) == 0) {
+            memset(block, 0, sizeof(InstrumentBlock));
+            block->next = blocks;
+            __atomic_store_n(&blocks, block, __ATOMIC_RELEASE);
+            n_blocks++;
+        }
+        else {
+            block = NULL;
+        }
+        pthread_mutex_unlock(&lock);
+        if (block == NULL || pthread_setspecific(key, block) != 0) {
+            if (block != NULL) {
+                retire(block);
+            }
+            mine = &spare;
+            return &mine->counters;
+        }
+        mine = block;
+    }
+    return &mine->counters;
+}
+
+/// Number of per-thread blocks of counters allocated so far.
+size_t TI_blocks(void) {
+    pthread_mutex_lock(&lock);
+    size_t n = n_blocks;
+    pthread_mutex_unlock(&lock);
+    return n;
+}
+
+/// Monotonic time in ns.
+uint64_t TI_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/// Add the time since start to a latency histogram.
+void TI_latency(uint64_t* histogram, uint64_t start) {
+    uint64_t ns = TI_now() - start;
+    int bucket = ns > 1 ? 63 - __builtin_clzll(ns) : 0;
+    if (bucket >= TI_LATENCY_BUCKETS) {
+        bucket = TI_LATENCY_BUCKETS - 1;
+    }
+    TI_ADD(histogram[bucket], 1);
+}
+
+/// Sum the counters of every thread, live or exited, into out.
+void TI_snapshot(InstrumentCounters* out) {
+    uint64_t* sum = (uint64_t*) out;
+    pthread_mutex_lock(&lock);
+    *out = retired;
+    InstrumentBlock* b = blocks;
+    for (; b != NULL; b = b->next) {
+        uint64_t* c = (uint64_t*) &b->counters;
+        for (size_t i = 0; i < N_COUNTERS; i++) {
+            sum[i] += __atomic_load_n(&c[i], __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/// Zero every thread's counters. Increments racing with the reset may be
+/// lost or kept.
+void TI_reset(void) {
+    pthread_mutex_lock(&lock);
+    memset(&retired, 0, sizeof(retired));
+    InstrumentBlock* b = blocks;
+    for (; b != NULL; b = b->next) {
+        uint64_t* c = (uint64_t*) &b->counters;
+        for (size_t i = 0; i < N_COUNTERS; i++) {
+            __atomic_store_n(&c[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+#else
+
+void TI_snapshot(InstrumentCounters* out) {
+    memset(out, 0, sizeof(InstrumentCounters));
+}
+
+void TI_reset(void) {
+}
+
+size_t TI_blocks(void) {
+    return 0;
+}
+
+#endif /* TIMING_INSTRUMENT */
@@ -0,0 +1,84 @@
+// Instrument Header
+// Optional counters for the resolver hot path. Build with
+//     make INSTRUMENT=1
+// (which defines TIMING_INSTRUMENT) to turn them on; otherwise every hook
+// below compiles to nothing.
+#ifndef __INSTRUMENT_H__
+#define __INSTRUMENT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "check-timing.h"
+
+// Branches of fs_dt_consistent.
+#define TI_FS_DT_AGREE      0   // fs and dt given and consistent.
+#define TI_FS_DT_DISAGREE   1   // fs and dt given, not consistent (status 1).
+#define TI_FS_ONLY          2
+#define TI_DT_ONLY          3
+#define TI_FS_DT_NEITHER    4   // status 2
+#define TI_FS_DT_BRANCHES   5
+
+// Branches of N_T_consistent.
+#define TI_NT_FS_FROM_N_T   0
+#define TI_NT_OVERDEFINED   1   // status 3
+#define TI_NT_INCONSISTENT  2   // status -2
+#define TI_NT_T_FROM_N      3
+#define TI_NT_N_NO_RATE     4   // status -1
+#define TI_NT_N_FROM_T      5
+#define TI_NT_T_NO_RATE     6   // status -1
+#define TI_NT_NOTHING       7   // status -1
+#define TI_NT_BRANCHES      8
+
+// Latency histogram buckets: bucket b counts calls taking [2^b, 2^(b+1)) ns,
+// bucket 0 also counts calls under 1 ns.
+#define TI_LATENCY_BUCKETS  32
+
+typedef struct InstrumentCounters {
+    uint64_t fs_dt[TI_FS_DT_BRANCHES];
+    uint64_t N_T[TI_NT_BRANCHES];
+    uint64_t status[6];     // Statuses -2 ... 3 of TP_check, TP_check_batch
+                            // and RP_check, at index status + 2.
+    uint64_t tp_latency[TI_LATENCY_BUCKETS];   // TP_check
+    uint64_t rp_latency[TI_LATENCY_BUCKETS];   // RP_check
+} InstrumentCounters;
+
+TIMING_API int TI_enabled(void);
+
+TIMING_API void TI_snapshot(InstrumentCounters* out);
+
+TIMING_API void TI_reset(void);
+
+TIMING_API size_t TI_blocks(void);
+
+#ifdef TIMING_INSTRUMENT
+
+InstrumentCounters* TI_counters(void);
+
+uint64_t TI_now(void);
+
+void TI_latency(uint64_t* histogram, uint64_t start);
+
+#define TI_FS_DT(branch) TI_ADD(TI_counters()->fs_dt[branch], 1)
+#define TI_N_T(branch) TI_ADD(TI_counters()->N_T[branch], 1)
+#define TI_STATUS(s) TI_ADD(TI_counters()->status[(s) + 2], 1)
+#define TI_START(name) uint64_t name = TI_now()
+#define TI_TP_LATENCY(start) TI_latency(TI_counters()->tp_latency, start)
+#define TI_RP_LATENCY(start) TI_latency(TI_counters()->rp_latency, start)
+
+// Only the owning thread writes its counters; the relaxed atomic store keeps
+// concurrent snapshots well defined and costs the same as a plain store.
+#define TI_ADD(counter, n) \
+    __atomic_store_n(&(counter), (counter) + (n), __ATOMIC_RELAXED)
+
+#else
+
+#define TI_FS_DT(branch) ((void) 0)
+#define TI_N_T(branch) ((void) 0)
+#define TI_STATUS(s) ((void) 0)
+#define TI_START(name) ((void) 0)
+#define TI_TP_LATENCY(start) ((void) 0)
+#define TI_RP_LATENCY(start) ((void) 0)
+
+#endif /* TIMING_INSTRUMENT */
+
+#endif /* __INSTRUMENT_H__ */
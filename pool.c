@@ -0,0 +1,63 @@
+/// pool.c
+/// An arena of TimingParameters and RampParameters.
+///
+/// TP_init and RP_init return a separate heap block for every parameter,
+/// which LabView has to free one by one. A ParameterPool is created once with
+/// room for capacity parameters of each type; slots are handed out with
+/// PP_tp and PP_rp, and all of them are released together with PP_reset or
+/// PP_free, even if LabView errored out before it could clean up.
+
+#include <stdlib.h>
+#include "pool.h"
+
+/// Create a pool with room for capacity TimingParameters and capacity
+/// RampParameters, using a single allocation. Returns NULL on failure.
+void* PP_create(size_t capacity) {
+    ParameterPool* pool = malloc(sizeof(ParameterPool) +
+                                 capacity * sizeof(TimingParameter) +
+                                 capacity * sizeof(RampParameter));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->tp = (TimingParameter*) (pool + 1);
+    pool->rp = (RampParameter*) (pool->tp + capacity);
+    pool->capacity = capacity;
+    pool->n_tp = 0;
+    pool->n_rp = 0;
+    return pool;
+}
+
+/// Take a TimingParameter from the pool and initialize it like TP_init.
+/// Returns NULL if the pool is exhausted.
+TimingParameter* PP_tp(ParameterPool* pool, double fs, double dt, double N,
+                       double T) {
+    if (pool->n_tp == pool->capacity) {
+        return NULL;
+    }
+    TimingParameter* tp = &pool->tp[pool->n_tp++];
+    TP_init_inplace(tp, fs, dt, N, T);
+    return tp;
+}
+
+/// Take a RampParameter from the pool and initialize it like RP_init.
+/// Returns NULL if the pool is exhausted.
+RampParameter* PP_rp(ParameterPool* pool, double yi, double yf, double dydt,
+                     double dy) {
+    if (pool->n_rp == pool->capacity) {
+        return NULL;
+    }
+    RampParameter* rp = &pool->rp[pool->n_rp++];
+    RP_init_inplace(rp, yi, yf, dydt, dy);
+    return rp;
+}
+
+/// Release every slot at once; pointers handed out earlier become invalid.
+void PP_reset(ParameterPool* pool) {
+    pool->n_tp = 0;
+    pool->n_rp = 0;
+}
+
+/// Free the pool and every parameter taken from it.
+void PP_free(ParameterPool* pool) {
+    free(pool);
+}
@@ -0,0 +1,30 @@
+// Pool Header
+// Hand out TimingParameters and RampParameters from one allocation.
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+typedef struct ParameterPools {
+    TimingParameter* tp;    // capacity slots of each type, allocated together
+    RampParameter* rp;      // with the pool itself.
+    size_t capacity;
+    size_t n_tp;            // Slots handed out so far.
+    size_t n_rp;
+} ParameterPool;
+
+TIMING_API void* PP_create(size_t capacity);
+
+TIMING_API TimingParameter* PP_tp(ParameterPool* pool, double fs, double dt,
+                                  double N, double T);
+
+TIMING_API RampParameter* PP_rp(ParameterPool* pool, double yi, double yf,
+                                double dydt, double dy);
+
+TIMING_API void PP_reset(ParameterPool* pool);
+
+TIMING_API void PP_free(ParameterPool* pool);
+
+#endif /* __POOL_H__ */
@@ -0,0 +1,194 @@
+/// ramp-shape.c
+/// Resolve and generate non-linear ramps.
+///
+/// RP_check_shaped times a shaped ramp by its steepest point: the profile u
+/// is stretched by at most RP_shape_slope = max |du/ds|, so T and N are those
+/// of a linear ramp that much taller. For RAMP_LINEAR it is RP_check.
+///
+/// RP_fill_shaped avoids a transcendental call per sample. The ramp is
+/// produced in blocks; each block costs one or two exp/log/cos calls for its
+/// first (or middle) sample, and the samples in it follow from that seed by
+///     expm1(a + b) = expm1(a) + expm1(b) + expm1(a) expm1(b)
+///     cos(a + b) = cos(a) cos(b) - sin(a) sin(b)
+/// with exp(b), cos(b) and sin(b) tabulated once per fill, or for log by
+///     log(x) = log(c) + 2 atanh(z),  z = (x - c) / (x + c)
+/// with a short odd series for atanh. exp and log are carried as expm1 and
+/// log1p of k s, so small k does not cancel. Reseeding every block keeps the
+/// error within a few ulps of calling exp/log/cos per sample, and the loops
+/// over a block are plain arithmetic that the compiler vectorizes.
+
+#include <tgmath.h>
+#include "ramp-shape.h"
+
+// Samples per block for RAMP_EXP and RAMP_SCURVE.
+#define SHAPE_BLOCK 64
+
+// Largest block for RAMP_LOG; smaller blocks are used for curved ramps.
+#define SHAPE_LOG_BLOCK 4096
+
+// |k| below which RAMP_EXP and RAMP_LOG are treated as linear; the shapes
+// tend to s as k -> 0 and lose precision near it.
+#define SHAPE_K_MIN 1e-6
+
+static const double pi = 3.14159265358979323846;
+
+/// The largest |du/ds| of the shape, 1 for a linear ramp, or 0 if the shape
+/// or k is invalid.
+double RP_shape_slope(ShapedRamp* sr) {
+    double k = sr->k;
+    switch (sr->shape) {
+    case RAMP_LINEAR:
+        return 1;
+    case RAMP_EXP:
+        if (!isfinite(k)) {
+            return 0;
+        }
+        if (fabs(k) < SHAPE_K_MIN) {
+            return 1;
+        }
+        // du/ds = k exp(k s) / (exp(k) - 1), largest at s = 1 for k > 0 and
+        // at s = 0 for k < 0.
+        return fabs(k) * fmax(1, exp(k)) / fabs(expm1(k));
+    case RAMP_LOG:
+        if (!(k > -1) || !isfinite(k)) {
+            return 0;
+        }
+        if (fabs(k) < SHAPE_K_MIN) {
+            return 1;
+        }
+        // du/ds = k / ((1 + k s) log(1 + k)), largest at s = 0 for k > 0
+        // and at s = 1 for k < 0.
+        return k / (fmin(1, 1 + k) * log1p(k));
+    case RAMP_SCURVE:
+        return pi / 2;
+    }
+    return 0;
+}
+
+/// RP_check for a shaped ramp: T is the time to cover the ramp without
+/// exceeding |dy/dt| = rp.dydt anywhere, and N the number of samples that
+/// keeps every step within about rp.dy.
+/// Returns the status of TP_check, or -1 if the shape or k is invalid.
+int RP_check_shaped(ShapedRamp* sr, TimingParameter* tp) {
+    RampParameter* rp = &sr->rp;
+    double slope = RP_shape_slope(sr);
+    if (!(slope > 0)) {
+        return -1;
+    }
+    double y_Delta = fmax(fabs(rp->yf - rp->yi), rp->y_Delta_min) * slope;
+    if (rp->dydt > 0) {
+        tp->T = y_Delta / rp->dydt;
+    }
+    if (rp->dy > 0) {
+        double N = floor(y_Delta / rp->dy + 0.5);
+        tp->N = fmax(N, 2);
+    }
+    return TP_check(tp);
+}
+
+// exp(k s) - 1 for s = 0 .. count - 1 times ds. With a = exp(k i ds) - 1 the
+// seed of the block at i and b = exp(k j ds) - 1 from the table,
+//     exp(k (i + j) ds) - 1 = a + b + a b,
+// which, unlike exp(k i ds) exp(k j ds) - 1, does not cancel for small k.
+static void fill_exp(double k, double ds, size_t count, double* y) {
+    double table[SHAPE_BLOCK];
+    for (size_t j = 0; j < SHAPE_BLOCK; j++) {
+        table[j] = expm1(k * (double) j * ds);
+    }
+    for (size_t i = 0; i < count; i += SHAPE_BLOCK) {
+        size_t m = count - i < SHAPE_BLOCK ? count - i : SHAPE_BLOCK;
+        double seed = expm1(k * (double) i * ds);
+        for (size_t j = 0; j < m; j++) {
+            y[i + j] = seed + table[j] + seed * table[j];
+        }
+    }
+}
+
+// 1 - cos(pi s).
+static void fill_scurve(double ds, size_t count, double* y) {
+    double c[SHAPE_BLOCK], s[SHAPE_BLOCK];
+    for (size_t j = 0; j < SHAPE_BLOCK; j++) {
+        c[j] = cos(pi * (double) j * ds);
+        s[j] = sin(pi * (double) j * ds);
+    }
+    for (size_t i = 0; i < count; i += SHAPE_BLOCK) {
+        size_t m = count - i < SHAPE_BLOCK ? count - i : SHAPE_BLOCK;
+        double cos_i = cos(pi * (double) i * ds);
+        double sin_i = sin(pi * (double) i * ds);
+        for (size_t j = 0; j < m; j++) {
+            y[i + j] = 1 - (cos_i * c[j] - sin_i * s[j]);
+        }
+    }
+}
+
+// log(1 + k s). Blocks are centred on c = 1 + k s_mid and sized so that
+// |z| <= 0.03, where the series below is accurate to double precision.
+// x - c, x + c and log(c) are formed from k s rather than from 1 + k s, so
+// nothing cancels for small k.
+// Ramps too short or too curved for blocks of 8 call log per sample.
+static void fill_log(double k, double ds, size_t count, double* y) {
+    double block = floor(0.12 * fmin(1, 1 + k) / (fabs(k) * ds));
+    if (block < 8) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = log1p(k * (double) i * ds);
+        }
+        return;
+    }
+    size_t B = block < SHAPE_LOG_BLOCK ? (size_t) block : SHAPE_LOG_BLOCK;
+    for (size_t i = 0; i < count; i += B) {
+        int m = (int) (count - i < B ? count - i : B);
+        double mid = 0.5 * (m - 1);
+        double c_m1 = k * ((double) i + mid) * ds;
+        double log_c = log1p(c_m1);
+        for (int j = 0; j < m; j++) {
+            double x_m1 = k * ((double) i + j) * ds;
+            double z = k * (j - mid) * ds / (2 + c_m1 + x_m1);
+            double z2 = z * z;
+            double series = 1 + z2 * (1.0 / 3 + z2 * (1.0 / 5 + z2 * (1.0 / 7
+                            + z2 * (1.0 / 9))));
+            y[i + j] = log_c + 2 * z * series;
+        }
+    }
+}
+
+/// Fill y with the tp->N samples of the shaped ramp; call RP_check_shaped
+/// first. The first and last samples are exactly yi and yf.
+/// Returns 0, or -1 if the shape or k is invalid, or tp->N is not a whole
+/// number >= 2 or exceeds len.
+int RP_fill_shaped(ShapedRamp* sr, TimingParameter* tp, double* y,
+                   size_t len) {
+    RampParameter* rp = &sr->rp;
+    double k = sr->k;
+    if (!(RP_shape_slope(sr) > 0)) {
+        return -1;
+    }
+    if (sr->shape == RAMP_LINEAR
+        || (sr->shape != RAMP_SCURVE && fabs(k) < SHAPE_K_MIN)) {
+        return RP_fill(rp, tp, y, NULL, 1, 0, len);
+    }
+    if (!(tp->N >= 2) || tp->N != floor(tp->N) || tp->N > (double) len) {
+        return -1;
+    }
+    size_t N = (size_t) tp->N;
+    double ds = 1.0 / (double) (N - 1);
+    double norm;
+    if (sr->shape == RAMP_EXP) {
+        fill_exp(k, ds, N, y);
+        norm = expm1(k);
+    }
+    else if (sr->shape == RAMP_LOG) {
+        fill_log(k, ds, N, y);
+        norm = log1p(k);
+    }
+    else {
+        fill_scurve(ds, N, y);
+        norm = 2;
+    }
+    double scale = (rp->yf - rp->yi) / norm;
+    for (size_t i = 0; i < N; i++) {
+        y[i] = rp->yi + y[i] * scale;
+    }
+    y[0] = rp->yi;
+    y[N - 1] = rp->yf;
+    return 0;
+}
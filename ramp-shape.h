@@ -0,0 +1,31 @@
+// Ramp Shape Header
+// Exponential, logarithmic and S-curve ramps.
+#ifndef __RAMPSHAPE_H__
+#define __RAMPSHAPE_H__
+
+#include <stddef.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+// Sample i of N is yi + (yf - yi) * u(s), s = i / (N - 1), where u is
+#define RAMP_LINEAR 0   // s
+#define RAMP_EXP    1   // (exp(k s) - 1) / (exp(k) - 1), k != 0
+#define RAMP_LOG    2   // log(1 + k s) / log(1 + k), k > -1, k != 0
+#define RAMP_SCURVE 3   // (1 - cos(pi s)) / 2, a raised cosine
+
+// A ramp with a shape. rp is used as in RP_check, except that rp.dydt is the
+// largest |dy/dt| and rp.dy the largest step anywhere on the ramp.
+typedef struct ShapedRamps {
+    RampParameter rp;
+    int shape;
+    double k;       // Curvature of RAMP_EXP and RAMP_LOG.
+} ShapedRamp;
+
+double RP_shape_slope(ShapedRamp* sr);
+
+int RP_check_shaped(ShapedRamp* sr, TimingParameter* tp);
+
+int RP_fill_shaped(ShapedRamp* sr, TimingParameter* tp, double* y,
+                   size_t len);
+
+#endif /* __RAMPSHAPE_H__ */
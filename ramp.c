@@ -7,9 +7,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tgmath.h>
 #include "check-timing.h"
+#include "instrument.h"
 #include "ramp.h"
+#include "simd.h"
 
 /// Print the contents of the RampParameter.
 void RP_print(RampParameter* rp) {
@@ -23,15 +26,22 @@ void RP_print(RampParameter* rp) {
 // Initialize a RampParameter on the heap.
 void* RP_init(double yi, double yf, double dydt, double dy) {
     RampParameter* rp = malloc(sizeof(RampParameter));
+    RP_init_inplace(rp, yi, yf, dydt, dy);
+    return rp;
+}
+
+// Initialize a RampParameter owned by the caller without allocating.
+void RP_init_inplace(RampParameter* rp, double yi, double yf, double dydt,
+                     double dy) {
     rp->yi = yi;
     rp->yf = yf;
     rp->dydt = dydt;
     rp->dy = dy;
     rp->y_Delta_min = 0.001;
-    return rp;
 }
 
 int RP_check(RampParameter* rp, TimingParameter* tp) {
+    TI_START(start);
     // Define the difference between y_initial and y_final
     double y_Delta = fmax(fabs(rp->yf - rp->yi), rp->y_Delta_min);
     if (rp->dydt > 0) {
@@ -44,5 +54,292 @@ int RP_check(RampParameter* rp, TimingParameter* tp) {
     }
     // Now everything is set up; just need to send this to the timing parameter
     int status = TP_check(tp);
+    TI_RP_LATENCY(start);
+    return status;
+}
+
+// Sample i of a ramp with N points is yi + i * (yf - yi) / (N - 1), and the
+// last sample is exactly yf. DAC codes are y * scale + offset, clamped to the
+// int16 range and rounded to nearest (ties to even), as the SIMD conversion
+// instructions do.
+static inline int16_t ramp_code(double y, double scale, double offset) {
+    double c = y * scale + offset;
+    c = c > -32768.0 ? c : -32768.0;
+    c = c < 32767.0 ? c : 32767.0;
+    return (int16_t) lrint(c);
+}
+
+#ifdef TIMING_SIMD_X86
+// Vector fills of samples start .. start + count - 1; they return how many
+// samples were written and leave the remainder to the scalar loop.
+static size_t ramp_fill_sse2(double yi, double step, size_t start, size_t count,
+                             double* y, int16_t* codes,
+                             double scale, double offset) {
+    const __m128d vyi = _mm_set1_pd(yi);
+    const __m128d vstep = _mm_set1_pd(step);
+    const __m128d vscale = _mm_set1_pd(scale);
+    const __m128d voffset = _mm_set1_pd(offset);
+    const __m128d lo = _mm_set1_pd(-32768.0);
+    const __m128d hi = _mm_set1_pd(32767.0);
+    const __m128d two = _mm_set1_pd(2.0);
+    __m128d idx = _mm_setr_pd((double) start, (double) start + 1);
+    size_t j = 0;
+    for (; j + 2 <= count; j += 2) {
+        __m128d v = _mm_add_pd(vyi, _mm_mul_pd(idx, vstep));
+        if (y) {
+            _mm_storeu_pd(y + j, v);
+        }
+        if (codes) {
+            __m128d c = _mm_add_pd(_mm_mul_pd(v, vscale), voffset);
+            c = _mm_min_pd(_mm_max_pd(c, lo), hi);
+            __m128i c32 = _mm_cvtpd_epi32(c);
+            int32_t packed = _mm_cvtsi128_si32(_mm_packs_epi32(c32, c32));
+            memcpy(codes + j, &packed, sizeof(packed));
+        }
+        idx = _mm_add_pd(idx, two);
+    }
+    return j;
+}
+
+TIMING_TARGET_AVX2
+static size_t ramp_fill_avx2(double yi, double step, size_t start, size_t count,
+                             double* y, int16_t* codes,
+                             double scale, double offset) {
+    const __m256d vyi = _mm256_set1_pd(yi);
+    const __m256d vstep = _mm256_set1_pd(step);
+    const __m256d vscale = _mm256_set1_pd(scale);
+    const __m256d voffset = _mm256_set1_pd(offset);
+    const __m256d lo = _mm256_set1_pd(-32768.0);
+    const __m256d hi = _mm256_set1_pd(32767.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    double s = (double) start;
+    __m256d idx = _mm256_setr_pd(s, s + 1, s + 2, s + 3);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m256d v = _mm256_add_pd(vyi, _mm256_mul_pd(idx, vstep));
+        if (y) {
+            _mm256_storeu_pd(y + j, v);
+        }
+        if (codes) {
+            __m256d c = _mm256_add_pd(_mm256_mul_pd(v, vscale), voffset);
+            c = _mm256_min_pd(_mm256_max_pd(c, lo), hi);
+            __m128i c32 = _mm256_cvtpd_epi32(c);
+            _mm_storel_epi64((__m128i*) (codes + j), _mm_packs_epi32(c32, c32));
+        }
+        idx = _mm256_add_pd(idx, four);
+    }
+    return j;
+}
+#endif
+
+/// Write samples start .. start + count - 1 of the N point ramp described by
+/// rp into y and/or codes (either may be NULL). y[0] is sample start.
+/// Any range of the ramp gives exactly the values a single fill of the whole
+/// ramp would, so ramps can be produced in pieces.
+/// Returns 0, or -1 (writing nothing) unless N >= 2 and the range lies
+/// within the ramp.
+int ramp_fill_range(RampParameter* rp, size_t N, size_t start, size_t count,
+                    double* y, int16_t* codes, double scale, double offset) {
+    if (N < 2 || start > N || count > N - start) {
+        return -1;
+    }
+    double step = (rp->yf - rp->yi) / (double) (N - 1);
+    size_t j = 0;
+#ifdef TIMING_SIMD_X86
+    int level = simd_level();
+    if (level == SIMD_AVX2) {
+        j = ramp_fill_avx2(rp->yi, step, start, count, y, codes, scale, offset);
+    }
+    else if (level == SIMD_SSE2) {
+        j = ramp_fill_sse2(rp->yi, step, start, count, y, codes, scale, offset);
+    }
+#endif
+    for (; j < count; j++) {
+        double v = rp->yi + (double) (start + j) * step;
+        if (y) {
+            y[j] = v;
+        }
+        if (codes) {
+            codes[j] = ramp_code(v, scale, offset);
+        }
+    }
+    // Pin the final sample to yf so rounding in step can't overshoot it.
+    if (start + count == N && count > 0) {
+        if (y) {
+            y[count - 1] = rp->yf;
+        }
+        if (codes) {
+            codes[count - 1] = ramp_code(rp->yf, scale, offset);
+        }
+    }
+    return 0;
+}
+
+/// Fill the caller's buffers with the tp->N samples of the ramp from rp->yi to
+/// rp->yf; call RP_check first. Either y or codes may be NULL; codes receives
+/// int16 DAC codes y * scale + offset. len is the capacity of the buffers.
+/// Returns 0, or -1 if tp->N is not a whole number >= 2 or exceeds len.
+int RP_fill(RampParameter* rp, TimingParameter* tp, double* y, int16_t* codes,
+            double scale, double offset, size_t len) {
+    if (!(tp->N >= 2) || tp->N != floor(tp->N) || tp->N > (double) len) {
+        return -1;
+    }
+    ramp_fill_range(rp, (size_t) tp->N, 0, (size_t) tp->N, y, codes, scale,
+                    offset);
+    return 0;
+}
+
+/// Resolve one timing shared by the n_channels ramps in rp, which are played
+/// together on one sample clock. As in RP_check, each ramp's rate dydt sets
+/// its duration and its resolution dy the samples it needs. The common T is
+/// the longest duration, so no channel exceeds its rate, and fs is the
+/// slowest rate that gives every channel its samples over T (and at least
+/// tp->fs or 1 / tp->dt, if set). tp->N then follows from TP_check, with at
+/// least 2 samples. When no channel sets a rate, tp->fs must be set, and T
+/// is the time the most samples take at it. Channels with yf == yi hold
+/// their level and do not constrain the timing (RP_check alone would time
+/// them by y_Delta_min). tp->eps is kept.
+/// Returns the status of TP_check, or -1 if a channel sets neither dydt nor
+/// dy or nothing fixes a sample rate.
+int RP_check_channels(RampParameter* rp, size_t n_channels,
+                      TimingParameter* tp) {
+    double fs = tp->fs > 0 ? tp->fs : (tp->dt > 0 ? 1.0 / tp->dt : 0);
+    double T = 0;
+    double N = 0;
+    for (size_t k = 0; k < n_channels; k++) {
+        if (rp[k].yf == rp[k].yi) {
+            continue;
+        }
+        double y_Delta = fmax(fabs(rp[k].yf - rp[k].yi), rp[k].y_Delta_min);
+        if (!(rp[k].dydt > 0) && !(rp[k].dy > 0)) {
+            return -1;
+        }
+        if (rp[k].dydt > 0) {
+            T = fmax(T, y_Delta / rp[k].dydt);
+        }
+        if (rp[k].dy > 0) {
+            N = fmax(N, fmax(floor(y_Delta / rp[k].dy + 0.5), 2));
+        }
+    }
+    if (T > 0 && N > 0) {
+        fs = fmax(fs, N / T);
+    }
+    if (!(fs > 0)) {
+        return -1;
+    }
+    TimingParameter common = {fs, 0, T > 0 ? 0 : N, T, tp->eps};
+    *tp = common;
+    int status = TP_check(tp);
+    if (status >= 0 && tp->N < 2) {
+        // A ramp needs both of its end points.
+        tp->N = 2;
+        tp->T = tp->N / tp->fs;
+    }
     return status;
 }
+
+// Channels filled per pass of the sample-major loop; their steps are kept on
+// the stack.
+#define CHANNEL_BLOCK 64
+
+/// Fill y and/or codes (either may be NULL) with the tp->N samples of each of
+/// the n_channels ramps in rp, resolved by RP_check_channels, in the order
+/// the DAQ write expects:
+///     RAMP_BY_SAMPLE   y[i * n_channels + k] (interleaved, one scan at a
+///                      time)
+///     RAMP_BY_CHANNEL  y[k * N + i] (all of channel 0, then channel 1, ...)
+/// Each channel's samples are exactly those RP_fill gives for it, and the
+/// buffers are written in one pass. len is the capacity of the buffers, in
+/// samples of all channels. Returns 0, or -1 if tp->N is not a whole number
+/// >= 2, the buffers hold fewer than tp->N * n_channels samples, or layout is
+/// unknown.
+int RP_fill_channels(RampParameter* rp, size_t n_channels, TimingParameter* tp,
+                     int layout, double* y, int16_t* codes, double scale,
+                     double offset, size_t len) {
+    if (!(tp->N >= 2) || tp->N != floor(tp->N)
+        || tp->N * (double) n_channels > (double) len) {
+        return -1;
+    }
+    size_t N = (size_t) tp->N;
+    if (layout == RAMP_BY_CHANNEL) {
+        for (size_t k = 0; k < n_channels; k++) {
+            ramp_fill_range(&rp[k], N, 0, N, y ? y + k * N : NULL,
+                            codes ? codes + k * N : NULL, scale, offset);
+        }
+        return 0;
+    }
+    if (layout != RAMP_BY_SAMPLE) {
+        return -1;
+    }
+    double yi[CHANNEL_BLOCK], step[CHANNEL_BLOCK];
+    for (size_t k0 = 0; k0 < n_channels; k0 += CHANNEL_BLOCK) {
+        size_t K = n_channels - k0 < CHANNEL_BLOCK ? n_channels - k0
+                                                    : CHANNEL_BLOCK;
+        for (size_t k = 0; k < K; k++) {
+            yi[k] = rp[k0 + k].yi;
+            step[k] = (rp[k0 + k].yf - rp[k0 + k].yi) / (double) (N - 1);
+        }
+        for (size_t i = 0; i < N - 1; i++) {
+            size_t row = i * n_channels + k0;
+            for (size_t k = 0; k < K; k++) {
+                double v = yi[k] + (double) i * step[k];
+                if (y) {
+                    y[row + k] = v;
+                }
+                if (codes) {
+                    codes[row + k] = ramp_code(v, scale, offset);
+                }
+            }
+        }
+        // The last scan is pinned to yf, as in ramp_fill_range.
+        size_t row = (N - 1) * n_channels + k0;
+        for (size_t k = 0; k < K; k++) {
+            if (y) {
+                y[row + k] = rp[k0 + k].yf;
+            }
+            if (codes) {
+                codes[row + k] = ramp_code(rp[k0 + k].yf, scale, offset);
+            }
+        }
+    }
+    return 0;
+}
+
+/// Set up rs to stream the ramp rp resolved into tp (see RP_check) in chunks
+/// of chunk samples. The ramp is copied, so rp and tp may be reused.
+/// Returns 0, or -1 if tp->N is not a whole number >= 2 or chunk is 0.
+int RS_init(RampStream* rs, RampParameter* rp, TimingParameter* tp,
+            size_t chunk, double scale, double offset) {
+    if (!(tp->N >= 2) || tp->N != floor(tp->N) || chunk == 0) {
+        return -1;
+    }
+    rs->rp = *rp;
+    rs->N = (size_t) tp->N;
+    rs->next = 0;
+    rs->chunk = chunk;
+    rs->scale = scale;
+    rs->offset = offset;
+    return 0;
+}
+
+/// Write the next chunk of samples into y and/or codes, which must hold
+/// rs->chunk values. Each sample is computed from its index, so chunk k is
+/// identical to samples k * chunk onwards of RP_fill, with no drift.
+/// Returns the number of samples written; 0 once the ramp is finished.
+size_t RS_next(RampStream* rs, double* y, int16_t* codes) {
+    size_t count = rs->N - rs->next;
+    if (count > rs->chunk) {
+        count = rs->chunk;
+    }
+    if (count > 0) {
+        ramp_fill_range(&rs->rp, rs->N, rs->next, count, y, codes,
+                        rs->scale, rs->offset);
+        rs->next += count;
+    }
+    return count;
+}
+
+/// Continue the stream from sample index (e.g. 0 to replay the ramp).
+void RS_seek(RampStream* rs, size_t index) {
+    rs->next = index < rs->N ? index : rs->N;
+}
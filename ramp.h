@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct RampParameters {
     double yi;
     double yf;
@@ -9,8 +12,50 @@ typedef struct RampParameters {
                         // calculating number of points, rate, etc.
 } RampParameter;
 
+// A resumable generator that emits a resolved ramp a chunk at a time, so
+// ramps with more samples than fit in memory can be streamed to the DAQ.
+typedef struct RampStreams {
+    RampParameter rp;
+    size_t N;       // Total number of samples in the ramp.
+    size_t next;    // Index of the next sample to emit.
+    size_t chunk;   // Samples per call to RS_next.
+    double scale;   // DAC code conversion; see RP_fill.
+    double offset;
+} RampStream;
+
 void RP_print(RampParameter* rp);
 
 void* RP_init(double yi, double yf, double dydt, double dy);
 
-int RP_check(RampParameter* rp, TimingParameter* tp);
+TIMING_API void RP_init_inplace(RampParameter* rp, double yi, double yf,
+                                double dydt, double dy);
+
+TIMING_API int RP_check(RampParameter* rp, TimingParameter* tp);
+
+TIMING_API int ramp_fill_range(RampParameter* rp, size_t N, size_t start,
+                               size_t count, double* y, int16_t* codes,
+                               double scale, double offset);
+
+TIMING_API int RP_fill(RampParameter* rp, TimingParameter* tp, double* y,
+                       int16_t* codes, double scale, double offset,
+                       size_t len);
+
+// Sample layouts of RP_fill_channels (DAQmx GroupByScanNumber and
+// GroupByChannel).
+#define RAMP_BY_SAMPLE  0
+#define RAMP_BY_CHANNEL 1
+
+TIMING_API int RP_check_channels(RampParameter* rp, size_t n_channels,
+                                 TimingParameter* tp);
+
+TIMING_API int RP_fill_channels(RampParameter* rp, size_t n_channels,
+                                TimingParameter* tp, int layout, double* y,
+                                int16_t* codes, double scale, double offset,
+                                size_t len);
+
+TIMING_API int RS_init(RampStream* rs, RampParameter* rp, TimingParameter* tp,
+                       size_t chunk, double scale, double offset);
+
+TIMING_API size_t RS_next(RampStream* rs, double* y, int16_t* codes);
+
+TIMING_API void RS_seek(RampStream* rs, size_t index);
@@ -0,0 +1,135 @@
+/// resolve-cache.c
+/// Memoize TP_check and RP_check for front panels that resolve the same
+/// inputs over and over.
+///
+/// The cache is an open-addressing hash table keyed on the exact bit patterns
+/// of the input fields, so a hit returns precisely what the resolver would.
+/// All memory is allocated by RC_init; when a short probe sequence finds no
+/// free slot, the entry in the first slot probed is replaced.
+
+#include <stdlib.h>
+#include <string.h>
+#include "resolve-cache.h"
+
+#define RC_KIND_TP 1
+#define RC_KIND_RP 2
+
+// Number of slots probed before an entry is evicted.
+#define RC_PROBES 8
+
+/// Allocate a cache with room for at least capacity entries (rounded up to a
+/// power of two). Returns 0, or -1 if the table can't be allocated.
+int RC_init(ResolveCache* rc, size_t capacity) {
+    size_t n = 1;
+    while (n < capacity) {
+        n <<= 1;
+    }
+    rc->entries = calloc(n, sizeof(CacheEntry));
+    if (rc->entries == NULL) {
+        return -1;
+    }
+    rc->mask = n - 1;
+    rc->hits = 0;
+    rc->misses = 0;
+    return 0;
+}
+
+/// Free the table.
+void RC_free(ResolveCache* rc) {
+    free(rc->entries);
+    rc->entries = NULL;
+}
+
+/// Drop every entry and reset the hit and miss counters.
+void RC_clear(ResolveCache* rc) {
+    memset(rc->entries, 0, (rc->mask + 1) * sizeof(CacheEntry));
+    rc->hits = 0;
+    rc->misses = 0;
+}
+
+static void key_from(uint64_t key[], TimingParameter* tp, RampParameter* rp) {
+    memset(key, 0, RC_KEY_WORDS * sizeof(uint64_t));
+    memcpy(key, &tp->fs, sizeof(double));
+    memcpy(key + 1, &tp->dt, sizeof(double));
+    memcpy(key + 2, &tp->N, sizeof(double));
+    memcpy(key + 3, &tp->T, sizeof(double));
+    memcpy(key + 4, &tp->eps, sizeof(double));
+    if (rp) {
+        memcpy(key + 5, &rp->yi, sizeof(double));
+        memcpy(key + 6, &rp->yf, sizeof(double));
+        memcpy(key + 7, &rp->dydt, sizeof(double));
+        memcpy(key + 8, &rp->dy, sizeof(double));
+        memcpy(key + 9, &rp->y_Delta_min, sizeof(double));
+    }
+}
+
+static uint64_t key_hash(uint64_t key[], int kind) {
+    uint64_t h = (uint64_t) kind;
+    for (int i = 0; i < RC_KEY_WORDS; i++) {
+        h = (h ^ key[i]) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+// Find the entry for key, or claim a slot for it. Returns the entry and sets
+// *hit if it already holds the result.
+static CacheEntry* lookup(ResolveCache* rc, uint64_t key[], int kind,
+                          int* hit) {
+    size_t home = (size_t) key_hash(key, kind) & rc->mask;
+    CacheEntry* free_slot = NULL;
+    for (size_t p = 0; p < RC_PROBES; p++) {
+        CacheEntry* e = &rc->entries[(home + p) & rc->mask];
+        if (e->kind == 0) {
+            free_slot = e;
+            break;
+        }
+        if (e->kind == kind &&
+            memcmp(e->key, key, RC_KEY_WORDS * sizeof(uint64_t)) == 0) {
+            *hit = 1;
+            return e;
+        }
+    }
+    *hit = 0;
+    return free_slot ? free_slot : &rc->entries[home];
+}
+
+/// TP_check, with the result taken from or stored in the cache.
+int RC_TP_check(ResolveCache* rc, TimingParameter* tp) {
+    uint64_t key[RC_KEY_WORDS];
+    int hit;
+    key_from(key, tp, NULL);
+    CacheEntry* e = lookup(rc, key, RC_KIND_TP, &hit);
+    if (hit) {
+        rc->hits++;
+        *tp = e->tp;
+        return e->status;
+    }
+    rc->misses++;
+    int status = TP_check(tp);
+    memcpy(e->key, key, sizeof(key));
+    e->tp = *tp;
+    e->status = status;
+    e->kind = RC_KIND_TP;
+    return status;
+}
+
+/// RP_check, with the result taken from or stored in the cache.
+int RC_RP_check(ResolveCache* rc, RampParameter* rp, TimingParameter* tp) {
+    uint64_t key[RC_KEY_WORDS];
+    int hit;
+    key_from(key, tp, rp);
+    CacheEntry* e = lookup(rc, key, RC_KIND_RP, &hit);
+    if (hit) {
+        rc->hits++;
+        *tp = e->tp;
+        return e->status;
+    }
+    rc->misses++;
+    int status = RP_check(rp, tp);
+    memcpy(e->key, key, sizeof(key));
+    e->tp = *tp;
+    e->status = status;
+    e->kind = RC_KIND_RP;
+    return status;
+}
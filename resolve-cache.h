@@ -0,0 +1,38 @@
+// Resolve Cache Header
+// A fixed-size memo cache in front of TP_check and RP_check.
+#ifndef __RESOLVECACHE_H__
+#define __RESOLVECACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+#define RC_KEY_WORDS 10
+
+typedef struct CacheEntries {
+    uint64_t key[RC_KEY_WORDS]; // Bit patterns of the TimingParameter and (for
+                                // RP_check) RampParameter inputs.
+    TimingParameter tp;         // The resolved TimingParameter.
+    int status;
+    int kind;                   // 0 for an empty slot.
+} CacheEntry;
+
+typedef struct ResolveCaches {
+    CacheEntry* entries;
+    size_t mask;                // Number of entries - 1.
+    uint64_t hits;
+    uint64_t misses;
+} ResolveCache;
+
+int RC_init(ResolveCache* rc, size_t capacity);
+
+void RC_free(ResolveCache* rc);
+
+void RC_clear(ResolveCache* rc);
+
+int RC_TP_check(ResolveCache* rc, TimingParameter* tp);
+
+int RC_RP_check(ResolveCache* rc, RampParameter* rp, TimingParameter* tp);
+
+#endif /* __RESOLVECACHE_H__ */
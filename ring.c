@@ -0,0 +1,207 @@
+/// ring.c
+/// Hand blocks of generated ramp samples from the thread that computes them
+/// to the thread that writes them to the DAQ, without locks.
+///
+/// The ring holds n_blocks preallocated blocks. The producer fills the block
+/// at head and publishes it by advancing head with a release store; the
+/// consumer sees it with an acquire load of head, writes it out, and hands it
+/// back by advancing tail the same way. Each index is only written by one
+/// thread, so no compare-and-swap is needed.
+///
+/// SR_run_ramp drives a RampStream through the ring into a RingWriter, which
+/// stands in for the DAQ write call. Stalls (producer waiting on a full
+/// ring) mean the writer is the bottleneck, which is what a continuous
+/// output wants; underruns (writer waiting on an empty ring) would be gaps in
+/// the output. Both sides poll, so each counts one event per wait, however
+/// many polls it takes. The latency of each block from publish to pickup is
+/// recorded.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ring.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/// Allocate a ring of n_blocks (rounded up to a power of two) blocks of
+/// block_len samples. Returns 0, or -1 if the allocation fails.
+int SR_init(SampleRing* ring, size_t n_blocks, size_t block_len) {
+    size_t n = 1;
+    while (n < n_blocks) {
+        n <<= 1;
+    }
+    ring->blocks = malloc(n * sizeof(RingBlock));
+    double* samples = malloc(n * block_len * sizeof(double));
+    if (ring->blocks == NULL || samples == NULL || block_len == 0) {
+        free(ring->blocks);
+        free(samples);
+        ring->blocks = NULL;
+        return -1;
+    }
+    for (size_t b = 0; b < n; b++) {
+        ring->blocks[b].samples = samples + b * block_len;
+        ring->blocks[b].count = 0;
+    }
+    ring->n_blocks = n;
+    ring->block_len = block_len;
+    ring->producer.head = 0;
+    ring->producer.stalls = 0;
+    ring->producer.full = 0;
+    ring->producer.done = 0;
+    ring->consumer.tail = 0;
+    ring->consumer.underruns = 0;
+    ring->consumer.empty = 0;
+    ring->consumer.n_blocks = 0;
+    ring->consumer.latency_sum = 0;
+    ring->consumer.latency_min = 0;
+    ring->consumer.latency_max = 0;
+    return 0;
+}
+
+void SR_free(SampleRing* ring) {
+    if (ring->blocks) {
+        free(ring->blocks[0].samples);
+        free(ring->blocks);
+        ring->blocks = NULL;
+    }
+}
+
+/// Producer: the next block to fill, or NULL if the ring is full. The first
+/// NULL after a block is counted as a stall.
+RingBlock* SR_producer_block(SampleRing* ring) {
+    RingProducer* p = &ring->producer;
+    size_t tail = __atomic_load_n(&ring->consumer.tail, __ATOMIC_ACQUIRE);
+    if (p->head - tail == ring->n_blocks) {
+        p->stalls += !p->full;
+        p->full = 1;
+        return NULL;
+    }
+    p->full = 0;
+    return &ring->blocks[p->head & (ring->n_blocks - 1)];
+}
+
+/// Producer: hand the block from SR_producer_block to the consumer.
+void SR_publish(SampleRing* ring) {
+    size_t head = ring->producer.head;
+    ring->blocks[head & (ring->n_blocks - 1)].t_publish = now();
+    __atomic_store_n(&ring->producer.head, head + 1, __ATOMIC_RELEASE);
+}
+
+/// Producer: no more blocks will be published.
+void SR_finish(SampleRing* ring) {
+    __atomic_store_n(&ring->producer.done, 1, __ATOMIC_RELEASE);
+}
+
+/// Consumer: the oldest published block, or NULL if the ring is empty.
+/// Running dry before SR_finish and then getting another block counts as
+/// one underrun. The underrun is counted when the block arrives, so the
+/// moment between the last block and SR_finish is not mistaken for a gap.
+RingBlock* SR_consumer_block(SampleRing* ring) {
+    RingConsumer* c = &ring->consumer;
+    size_t tail = c->tail;
+    int done = __atomic_load_n(&ring->producer.done, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&ring->producer.head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        c->empty = !done;
+        return NULL;
+    }
+    c->underruns += c->empty;
+    c->empty = 0;
+    RingBlock* block = &ring->blocks[tail & (ring->n_blocks - 1)];
+    double latency = now() - block->t_publish;
+    if (c->n_blocks == 0 || latency < c->latency_min) {
+        c->latency_min = latency;
+    }
+    if (latency > c->latency_max) {
+        c->latency_max = latency;
+    }
+    c->latency_sum += latency;
+    c->n_blocks++;
+    return block;
+}
+
+/// Consumer: give the block from SR_consumer_block back to the producer.
+void SR_release(SampleRing* ring) {
+    __atomic_store_n(&ring->consumer.tail, ring->consumer.tail + 1,
+                     __ATOMIC_RELEASE);
+}
+
+typedef struct RingRuns {
+    SampleRing* ring;
+    RingWriter write;
+    void* context;
+    int status;
+} RingRun;
+
+static void* writer_thread(void* arg) {
+    RingRun* run = arg;
+    SampleRing* ring = run->ring;
+    // Prime the ring before starting, as a DAQ fills its buffer before the
+    // output starts; only waits after that are underruns. head and tail keep
+    // counting across runs, so the fill is head - tail.
+    while (__atomic_load_n(&ring->producer.head, __ATOMIC_ACQUIRE) -
+           ring->consumer.tail < ring->n_blocks &&
+           !__atomic_load_n(&ring->producer.done, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    for (;;) {
+        RingBlock* block = SR_consumer_block(ring);
+        if (block == NULL) {
+            if (__atomic_load_n(&ring->producer.done, __ATOMIC_ACQUIRE) &&
+                __atomic_load_n(&ring->producer.head, __ATOMIC_ACQUIRE) ==
+                ring->consumer.tail) {
+                return NULL;
+            }
+            sched_yield();
+            continue;
+        }
+        if (run->status == 0) {
+            run->status = run->write(block->samples, block->count,
+                                     run->context);
+        }
+        SR_release(ring);
+    }
+}
+
+/// Generate the ramp rs on the calling thread and write it through write on
+/// a second thread, block by block. rs->chunk must not exceed the ring's
+/// block_len. Once write returns nonzero the remaining blocks are dropped.
+/// The ring may be reused for further runs; its counters accumulate.
+/// Returns 0, the first nonzero value returned by write, or -1 if the
+/// writer thread can't be started or the chunk is too large.
+int SR_run_ramp(SampleRing* ring, RampStream* rs, RingWriter write,
+                void* context) {
+    if (rs->chunk > ring->block_len) {
+        return -1;
+    }
+    RingRun run = {ring, write, context, 0};
+    pthread_t thread;
+    // A wait that ended the last run is not carried into this one.
+    ring->producer.done = 0;
+    ring->producer.full = 0;
+    ring->consumer.empty = 0;
+    if (pthread_create(&thread, NULL, writer_thread, &run) != 0) {
+        return -1;
+    }
+    for (;;) {
+        RingBlock* block = SR_producer_block(ring);
+        if (block == NULL) {
+            sched_yield();
+            continue;
+        }
+        block->index = rs->next;
+        block->count = RS_next(rs, block->samples, NULL);
+        if (block->count == 0) {
+            break;
+        }
+        SR_publish(ring);
+    }
+    SR_finish(ring);
+    pthread_join(thread, NULL);
+    return run.status;
+}
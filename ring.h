@@ -0,0 +1,67 @@
+// Ring Header
+// A lock-free single-producer, single-consumer ring of sample blocks.
+#ifndef __RING_H__
+#define __RING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+typedef struct RingBlocks {
+    double* samples;    // block_len samples owned by the ring.
+    size_t count;       // Number of valid samples.
+    size_t index;       // Ramp index of samples[0].
+    double t_publish;   // When the producer published the block, in seconds.
+} RingBlock;
+
+// Each side's position and counters are on their own cache line, so the
+// producer and consumer threads don't invalidate each other's caches.
+typedef struct RingProducers {
+    size_t head;        // Blocks published so far.
+    uint64_t stalls;    // Times the producer filled the ring and had to
+                        // wait: backpressure from a writer that keeps up,
+                        // not a gap.
+    int full;           // The last SR_producer_block found the ring full.
+    int done;           // Set once the last block is published.
+} __attribute__((aligned(64))) RingProducer;
+
+typedef struct RingConsumers {
+    size_t tail;        // Blocks released so far.
+    uint64_t underruns; // Gaps: times the writer ran the ring dry mid-stream
+                        // and then had to wait for the next block.
+    int empty;          // The last SR_consumer_block found the ring empty.
+    uint64_t n_blocks;  // Blocks consumed, and their latency from publish to
+    double latency_sum; // pickup by the writer, in seconds.
+    double latency_min;
+    double latency_max;
+} __attribute__((aligned(64))) RingConsumer;
+
+typedef struct SampleRings {
+    RingProducer producer;
+    RingConsumer consumer;
+    RingBlock* blocks;
+    size_t n_blocks;    // A power of two.
+    size_t block_len;
+} SampleRing;
+
+typedef int (*RingWriter)(const double* samples, size_t count, void* context);
+
+int SR_init(SampleRing* ring, size_t n_blocks, size_t block_len);
+
+void SR_free(SampleRing* ring);
+
+RingBlock* SR_producer_block(SampleRing* ring);
+
+void SR_publish(SampleRing* ring);
+
+void SR_finish(SampleRing* ring);
+
+RingBlock* SR_consumer_block(SampleRing* ring);
+
+void SR_release(SampleRing* ring);
+
+int SR_run_ramp(SampleRing* ring, RampStream* rs, RingWriter write,
+                void* context);
+
+#endif /* __RING_H__ */
@@ -0,0 +1,131 @@
+/// sample-clock.c
+/// Snap sampling frequencies to the rates a DAQ card can actually produce.
+///
+/// Cards derive the sample clock by dividing a fixed timebase by an integer,
+/// so the card silently coerces the requested fs. TP_check_hw resolves a
+/// TimingParameter with the rate the card will really use. Counters often
+/// take any 32 bit divisor, so the rates are not tabulated: each lookup
+/// estimates the divisor as timebase / fs and corrects it by a step or two
+/// against the rates as they round in doubles.
+
+#include <tgmath.h>
+#include "sample-clock.h"
+
+// The rate of divisor d, exactly as the lookups compare it.
+static double rate(const SampleClock* sc, uint64_t d) {
+    return sc->timebase / (double) d;
+}
+
+// timebase / fs clamped to the divisor range; fs must be > 0.
+static uint64_t estimate(const SampleClock* sc, double d) {
+    if (!(d > sc->div_min)) {
+        return sc->div_min;
+    }
+    if (!(d < sc->div_max)) {
+        return sc->div_max;
+    }
+    return (uint64_t) d;
+}
+
+/// Set up a card with the given timebase (Hz) and divisor range. Nothing is
+/// allocated, so the range may span every 32 bit divisor.
+/// Returns 0, or -1 (leaving no rates) if the arguments are invalid.
+int SC_init(SampleClock* sc, double timebase, uint32_t div_min,
+            uint32_t div_max) {
+    sc->n_rates = 0;
+    if (!(timebase > 0) || div_min < 1 || div_max < div_min) {
+        return -1;
+    }
+    sc->timebase = timebase;
+    sc->div_min = div_min;
+    sc->div_max = div_max;
+    sc->n_rates = (size_t) (div_max - div_min) + 1;
+    return 0;
+}
+
+/// Release sc. It holds no memory, so this only leaves it without rates;
+/// it is kept so callers pair every SC_init with it.
+void SC_free(SampleClock* sc) {
+    sc->n_rates = 0;
+}
+
+/// Rate k in ascending order, timebase / (div_max - k), for
+/// k < sc->n_rates.
+double SC_rate(const SampleClock* sc, size_t k) {
+    return rate(sc, (uint64_t) sc->div_max - k);
+}
+
+/// Return the achievable rate closest to fs, clamped to the card's range,
+/// or 0 if the clock has no rates (SC_init failed).
+/// If divisor is not NULL and a rate was found, its divisor is stored there.
+double SC_coerce(SampleClock* sc, double fs, uint32_t* divisor) {
+    if (sc->n_rates == 0) {
+        return 0;
+    }
+    // d is the largest divisor whose rate is >= fs, or div_min if there is
+    // none; fs <= 0 or nan coerce to the slowest rate.
+    uint64_t d = sc->div_max;
+    if (fs > 0) {
+        d = estimate(sc, sc->timebase / fs);
+        while (d < sc->div_max && rate(sc, d + 1) >= fs) {
+            d++;
+        }
+        while (d > sc->div_min && rate(sc, d) < fs) {
+            d--;
+        }
+        // The next slower rate wins if it is strictly closer.
+        if (d < sc->div_max && rate(sc, d) >= fs
+            && fs - rate(sc, d + 1) < rate(sc, d) - fs) {
+            d++;
+        }
+    }
+    if (divisor) {
+        *divisor = (uint32_t) d;
+    }
+    return rate(sc, d);
+}
+
+/// Return the fastest achievable rate <= fs, or 0 if every rate is faster
+/// or the clock has no rates.
+/// If divisor is not NULL and a rate was found, its divisor is stored there.
+double SC_floor(SampleClock* sc, double fs, uint32_t* divisor) {
+    if (sc->n_rates == 0 || !(rate(sc, sc->div_max) <= fs)) {
+        return 0;
+    }
+    // The smallest divisor whose rate is <= fs; div_max qualifies.
+    uint64_t d = estimate(sc, ceil(sc->timebase / fs));
+    while (d > sc->div_min && rate(sc, d - 1) <= fs) {
+        d--;
+    }
+    while (rate(sc, d) > fs) {
+        d++;
+    }
+    if (divisor) {
+        *divisor = (uint32_t) d;
+    }
+    return rate(sc, d);
+}
+
+/// Resolve tp like TP_check, then replace fs with the rate the card will use
+/// and recompute dt, N and T from it. N is kept if it was given; if only T
+/// was given, N is recomputed from T at the coerced rate. T is always the
+/// real duration N / fs.
+/// Returns the status of TP_check; tp is not coerced if the status is < 0.
+/// Returns -1, leaving tp alone, if the clock has no rates.
+int TP_check_hw(TimingParameter* tp, SampleClock* sc) {
+    if (sc->n_rates == 0) {
+        return -1;
+    }
+    int N_defined = tp->N > 0;
+    int status = TP_check(tp);
+    if (status < 0) {
+        return status;
+    }
+    tp->fs = SC_coerce(sc, tp->fs, NULL);
+    tp->dt = 1.0 / tp->fs;
+    if (!N_defined) {
+        tp->N = floor(tp->T * tp->fs + 0.5);
+    }
+    tp->T = tp->N / tp->fs;
+    return status;
+}
@@ -0,0 +1,31 @@
+// Sample Clock Header
+// DAQ sample clocks that can only run at timebase / divisor.
+#ifndef __SAMPLECLOCK_H__
+#define __SAMPLECLOCK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "check-timing.h"
+
+typedef struct SampleClocks {
+    double timebase;    // Frequency of the card's timebase, in Hz.
+    uint32_t div_min;   // Smallest and largest divisors the card accepts.
+    uint32_t div_max;
+    size_t n_rates;     // div_max - div_min + 1, or 0 if SC_init failed.
+                        // SC_rate(sc, k) lists them in ascending order.
+} SampleClock;
+
+TIMING_API int SC_init(SampleClock* sc, double timebase, uint32_t div_min,
+                       uint32_t div_max);
+
+TIMING_API void SC_free(SampleClock* sc);
+
+TIMING_API double SC_rate(const SampleClock* sc, size_t k);
+
+TIMING_API double SC_coerce(SampleClock* sc, double fs, uint32_t* divisor);
+
+TIMING_API double SC_floor(SampleClock* sc, double fs, uint32_t* divisor);
+
+TIMING_API int TP_check_hw(TimingParameter* tp, SampleClock* sc);
+
+#endif /* __SAMPLECLOCK_H__ */
@@ -0,0 +1,86 @@
+/// sequence.c
+/// Compiles a list of ramp, hold and step segments into one sample buffer.
+///
+/// SEQ_plan runs RP_check on every ramp and picks the highest sample rate any
+/// of them needs, so every ramp keeps at least its requested resolution dy.
+/// Each segment is then resolved at that common fs with TP_check, which gives
+/// its number of samples and its offset in the output. SEQ_render writes the
+/// samples into a buffer of seq->tp.N points supplied by the caller, so the
+/// whole waveform is built in one pass with a single allocation.
+
+#include <tgmath.h>
+#include "sequence.h"
+
+/// Choose the common sample rate and lay out the segments.
+/// A ramp that sets only dydt or only dy is resolved at seq->tp.fs, the way
+/// RP_check_channels resolves it on a fixed clock.
+/// Returns 0, the status of the first ramp that RP_check rejected, or -1 if
+/// no segment fixes a sample rate and seq->tp.fs is not set.
+int SEQ_plan(Sequence* seq) {
+    double clock = seq->tp.fs > 0 ? seq->tp.fs : 0;
+    double fs = clock;
+    for (size_t i = 0; i < seq->n_segments; i++) {
+        Segment* seg = &seq->segments[i];
+        if (seg->kind == SEG_RAMP) {
+            TimingParameter tp = {0, 0, 0, 0, seq->tp.eps};
+            if (!(seg->rp.dydt > 0 && seg->rp.dy > 0)) {
+                tp.fs = clock;
+            }
+            int status = RP_check(&seg->rp, &tp);
+            if (status < 0) {
+                return status;
+            }
+            fs = fmax(fs, tp.fs);
+            seg->T = tp.T;
+        }
+    }
+    if (!(fs > 0)) {
+        return -1;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < seq->n_segments; i++) {
+        Segment* seg = &seq->segments[i];
+        TimingParameter tp = {fs, 0, 0, seg->T, seq->tp.eps};
+        if (seg->T > 0) {
+            int status = TP_check(&tp);
+            if (status < 0) {
+                return status;
+            }
+        }
+        // A ramp needs both of its end points.
+        seg->N = (size_t) fmax(tp.N, seg->kind == SEG_RAMP ? 2 : 0);
+        seg->offset = offset;
+        offset += seg->N;
+    }
+    seq->tp.fs = fs;
+    seq->tp.dt = 1.0 / fs;
+    seq->tp.N = (double) offset;
+    seq->tp.T = offset / fs;
+    return 0;
+}
+
+/// Write the planned sequence into y, which holds len samples.
+/// Returns 0, or -1 if len is smaller than seq->tp.N.
+int SEQ_render(Sequence* seq, double* y, size_t len) {
+    if (seq->tp.N > (double) len) {
+        return -1;
+    }
+    double level = seq->y0;
+    for (size_t i = 0; i < seq->n_segments; i++) {
+        Segment* seg = &seq->segments[i];
+        double* out = y + seg->offset;
+        if (seg->kind == SEG_RAMP) {
+            ramp_fill_range(&seg->rp, seg->N, 0, seg->N, out, NULL, 1, 0);
+            level = seg->rp.yf;
+            continue;
+        }
+        if (seg->kind == SEG_STEP) {
+            level = seg->y;
+        }
+        for (size_t j = 0; j < seg->N; j++) {
+            out[j] = level;
+        }
+    }
+    return 0;
+}
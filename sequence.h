@@ -0,0 +1,35 @@
+// Sequence Header
+// A waveform made of ramp, hold and step segments played at one sample rate.
+#ifndef __SEQUENCE_H__
+#define __SEQUENCE_H__
+
+#include <stddef.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+#define SEG_RAMP 0  // Ramp from rp.yi to rp.yf, timed by RP_check.
+#define SEG_HOLD 1  // Hold the previous level for T seconds.
+#define SEG_STEP 2  // Jump to y and hold it for T seconds.
+
+typedef struct Segments {
+    int kind;
+    RampParameter rp;   // SEG_RAMP only.
+    double y;           // SEG_STEP only.
+    double T;           // Duration; set by SEQ_plan for SEG_RAMP.
+    size_t N;           // Set by SEQ_plan: number of samples in the segment.
+    size_t offset;      // Set by SEQ_plan: index of the segment's first sample.
+} Segment;
+
+typedef struct Sequences {
+    Segment* segments;
+    size_t n_segments;
+    double y0;          // Level held by a hold before any ramp or step.
+    TimingParameter tp; // fs is a lower bound on input; SEQ_plan sets fs, dt,
+                        // the total N and the total T.
+} Sequence;
+
+int SEQ_plan(Sequence* seq);
+
+int SEQ_render(Sequence* seq, double* y, size_t len);
+
+#endif /* __SEQUENCE_H__ */
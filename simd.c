@@ -0,0 +1,50 @@
+/// simd.c
+/// Picks the widest instruction set supported by both the build and the CPU
+/// the first time a batch kernel runs. Tests and benchmarks can lower the level
+/// with simd_set_level to exercise the narrower kernels.
+///
+/// Sweep threads run the kernels concurrently, so the CPU is probed once
+/// under pthread_once and the level is read and written atomically.
+
+#include <pthread.h>
+#include "simd.h"
+
+static int level = -1;
+static int supported;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+static int simd_detect(void) {
+#ifdef TIMING_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    return SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+static void detect(void) {
+    supported = simd_detect();
+}
+
+/// The instruction set used by the batch kernels.
+int simd_level(void) {
+    int l = __atomic_load_n(&level, __ATOMIC_RELAXED);
+    if (l < 0) {
+        pthread_once(&detect_once, detect);
+        l = supported;
+        __atomic_store_n(&level, l, __ATOMIC_RELAXED);
+    }
+    return l;
+}
+
+/// Request an instruction set; -1 restores automatic detection. The level is
+/// capped at what the CPU supports. Returns the level actually selected.
+int simd_set_level(int requested) {
+    pthread_once(&detect_once, detect);
+    int l = requested < 0 || requested > supported ? supported : requested;
+    __atomic_store_n(&level, l, __ATOMIC_RELAXED);
+    return l;
+}
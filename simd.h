@@ -0,0 +1,34 @@
+// SIMD Header
+// Runtime CPU dispatch for the vectorized batch kernels in check-timing.c and
+// ramp.c.
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+// The vector kernels are only built for x86-64 with gcc or clang. Every other
+// target uses the scalar code. Scalar double math on x86-64 already uses SSE2,
+// so the vector and scalar paths round identically.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TIMING_SIMD_X86 1
+#include <immintrin.h>
+#define TIMING_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Let gcc if-convert and vectorize floating point code that could raise
+// exceptions (clang does by default). Only for code that doesn't look at the
+// exception flags.
+#if defined(__GNUC__) && !defined(__clang__)
+#define TIMING_NO_TRAPS __attribute__((optimize("no-trapping-math")))
+#else
+#define TIMING_NO_TRAPS
+#endif
+
+// Instruction sets the batch kernels know about.
+#define SIMD_SCALAR 0
+#define SIMD_SSE2   1
+#define SIMD_AVX2   2
+
+int simd_level(void);
+
+int simd_set_level(int level);
+
+#endif /* __SIMD_H__ */
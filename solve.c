@@ -0,0 +1,174 @@
+/// solve.c
+/// Pick the timing of a ramp from its limits instead of fixing fs by hand.
+///
+/// A ramp of height y_Delta needs
+///     T >= y_Delta / dydt     (the rate limit)
+///     N >= y_Delta / dy       (the resolution, rounded as RP_check does)
+/// and the hardware needs fs = N / T <= min(fs_max, 1 / dt_min) and
+/// N <= fifo. With any rate available, the fewest samples N_min also give the
+/// shortest time, T = max(T_rate, N_min / fs_max), so both objectives have
+/// the same closed-form answer. A SampleClock only offers timebase / divisor,
+/// and N must cover T at the chosen rate, so the objectives differ:
+/// SOLVE_MIN_SAMPLES takes the fastest rate at which N_min samples still
+/// last T_rate, found by one SC_floor, and SOLVE_MIN_TIME tries the
+/// SOLVE_RATES fastest usable rates, which puts T within a sample period of
+/// the rate limit. Either way the cost is independent of the clock's range,
+/// so RP_solve can run on every front panel edit.
+
+#include <tgmath.h>
+#include "solve.h"
+
+// TP_status_message describes SOLVE_INFEASIBLE as -4.
+__extension__ _Static_assert(SOLVE_INFEASIBLE == -4
+                             && SOLVE_INFEASIBLE >= TP_STATUS_MIN,
+                             "SOLVE_INFEASIBLE must match TP_status_message");
+
+// Rates tried by SOLVE_MIN_TIME with a SampleClock.
+#define SOLVE_RATES 64
+
+// Samples to last at least T at rate fs. The tolerance keeps products like
+// 100.00000000001 from costing a whole extra sample.
+static double samples_for(double T, double fs) {
+    return ceil(T * fs * (1 - 1e-12));
+}
+
+/// Resolve the ramp rp into tp using as little time (SOLVE_MIN_TIME) or as
+/// few samples (SOLVE_MIN_SAMPLES) as the limits in hw allow. rp.dydt is the
+/// fastest allowed rate and rp.dy the largest allowed step; either may be 0.
+/// If binding is not NULL, it receives the SOLVE_* constraints that are
+/// tight at the solution, or that conflict if there is none.
+/// Returns 0; -1 if objective is unknown, hw->clock has no rates (SC_init
+/// failed), or nothing bounds the time (no dydt and no rate limit); or
+/// SOLVE_INFEASIBLE.
+int RP_solve(RampParameter* rp, const HardwareLimit* hw, int objective,
+             TimingParameter* tp, unsigned* binding) {
+    unsigned bind = 0;
+    unsigned unused;
+    if (binding == NULL) {
+        binding = &unused;
+    }
+    *binding = 0;
+    if (objective != SOLVE_MIN_TIME && objective != SOLVE_MIN_SAMPLES) {
+        return -1;
+    }
+    if (hw->clock != NULL && hw->clock->n_rates == 0) {
+        return -1;
+    }
+    double y_Delta = fmax(fabs(rp->yf - rp->yi), rp->y_Delta_min);
+    double T_rate = rp->dydt > 0 ? y_Delta / rp->dydt : 0;
+    double N_min = rp->dy > 0 ? fmax(floor(y_Delta / rp->dy + 0.5), 2) : 2;
+    double fifo = hw->fifo > 0 ? (double) hw->fifo : INFINITY;
+
+    // The fastest rate allowed, and which limit sets it.
+    double fs_hi = INFINITY;
+    unsigned fs_limit = 0;
+    if (hw->fs_max > 0) {
+        fs_hi = hw->fs_max;
+        fs_limit = SOLVE_FS_MAX;
+    }
+    if (hw->dt_min > 0 && 1.0 / hw->dt_min <= fs_hi) {
+        fs_limit = 1.0 / hw->dt_min == fs_hi ? fs_limit | SOLVE_DT_MIN
+                                              : SOLVE_DT_MIN;
+        fs_hi = 1.0 / hw->dt_min;
+    }
+    SampleClock* sc = hw->clock;
+    if (sc != NULL) {
+        double fastest = SC_rate(sc, sc->n_rates - 1);
+        if (fastest < fs_hi) {
+            fs_hi = fastest;
+            fs_limit = SOLVE_FS_MAX;
+        }
+    }
+    if (N_min > fifo) {
+        *binding = SOLVE_RESOLUTION | SOLVE_FIFO;
+        return SOLVE_INFEASIBLE;
+    }
+    if (fs_hi == INFINITY && T_rate == 0) {
+        return -1;
+    }
+    if (rp->dy > 0) {
+        bind |= SOLVE_RESOLUTION;
+    }
+
+    if (sc == NULL) {
+        if (T_rate >= N_min / fs_hi) {
+            TP_init_inplace(tp, 0, 0, N_min, T_rate);
+            bind |= SOLVE_RATE;
+            if (T_rate == N_min / fs_hi) {
+                bind |= fs_limit;
+            }
+        }
+        else {
+            TP_init_inplace(tp, fs_hi, 0, N_min, 0);
+            bind |= fs_limit;
+        }
+        if (N_min == fifo) {
+            bind |= SOLVE_FIFO;
+        }
+        *binding = bind;
+        return TP_check(tp);
+    }
+
+    // Rates above fs_top overflow the FIFO or break a limit.
+    double fs_top = fs_hi;
+    if (T_rate > 0 && fifo / T_rate < fs_top) {
+        fs_top = fifo / T_rate;
+        fs_limit = SOLVE_FIFO;
+    }
+    uint32_t divisor;
+    double top = SC_floor(sc, fs_top, &divisor);
+    if (top == 0) {
+        *binding = fs_limit | SOLVE_CLOCK | (T_rate > 0 ? SOLVE_RATE : 0);
+        return SOLVE_INFEASIBLE;
+    }
+    double fs;
+    double N;
+    if (objective == SOLVE_MIN_SAMPLES && T_rate > 0 && N_min / T_rate < top) {
+        // The fastest rate at which N_min samples are slow enough; if even
+        // the slowest rate is too fast, as few samples as it allows.
+        fs = SC_floor(sc, N_min / T_rate, NULL);
+        if (fs > 0) {
+            N = N_min;
+        }
+        else {
+            fs = SC_rate(sc, 0);
+            N = samples_for(T_rate, fs);
+        }
+    }
+    else {
+        // Slower rates need fewer samples, but once N reaches N_min they
+        // only take longer, so the search stops there.
+        size_t k = sc->div_max - divisor;
+        double n = 0;
+        fs = 0;
+        N = 0;
+        for (size_t j = 0; j < SOLVE_RATES && j <= k && n != N_min; j++) {
+            double r = SC_rate(sc, k - j);
+            n = fmax(N_min, samples_for(T_rate, r));
+            if (fs == 0 || n / r < N / fs || (n / r == N / fs && n < N)) {
+                fs = r;
+                N = n;
+            }
+        }
+    }
+    TP_init_inplace(tp, fs, 0, N, 0);
+    int status = TP_check(tp);
+
+    if (T_rate > 0 && samples_for(T_rate, fs) >= N) {
+        bind |= SOLVE_RATE;
+    }
+    if (N != N_min) {
+        bind &= ~SOLVE_RESOLUTION;
+    }
+    if (fs == top) {
+        bind |= fs_limit;
+    }
+    if (N == fifo) {
+        bind |= SOLVE_FIFO;
+    }
+    if (tp->T > fmax(T_rate, N_min / fs_hi) * (1 + 1e-12)) {
+        bind |= SOLVE_CLOCK;
+    }
+    *binding = bind;
+    return status;
+}
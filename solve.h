@@ -0,0 +1,38 @@
+// Solve Header
+// Choose the fastest (or smallest) timing for a ramp within hardware limits.
+#ifndef __SOLVE_H__
+#define __SOLVE_H__
+
+#include <stddef.h>
+#include "check-timing.h"
+#include "ramp.h"
+#include "sample-clock.h"
+
+typedef struct HardwareLimits {
+    double fs_max;      // Fastest sample rate in Hz, or 0 if unlimited.
+    double dt_min;      // Shortest time between samples, or 0 if unlimited.
+    size_t fifo;        // Most samples the output buffer holds, or 0.
+    SampleClock* clock; // Rates the card can produce, or NULL for any rate.
+} HardwareLimit;
+
+// Objectives of RP_solve.
+#define SOLVE_MIN_TIME      0
+#define SOLVE_MIN_SAMPLES   1
+
+// Constraints that are tight at the solution (or, for an infeasible ramp,
+// that conflict).
+#define SOLVE_RATE          0x01    // |dy/dt| = rp.dydt.
+#define SOLVE_RESOLUTION    0x02    // N is the fewest samples rp.dy allows.
+#define SOLVE_FS_MAX        0x04    // fs is the fastest fs_max or the clock
+                                    // allows.
+#define SOLVE_DT_MIN        0x08    // fs is the fastest dt_min allows.
+#define SOLVE_FIFO          0x10    // N fills the FIFO.
+#define SOLVE_CLOCK         0x20    // The clock's rate steps cost time.
+
+// Returned when no timing satisfies every limit.
+#define SOLVE_INFEASIBLE    -4
+
+int RP_solve(RampParameter* rp, const HardwareLimit* hw, int objective,
+             TimingParameter* tp, unsigned* binding);
+
+#endif /* __SOLVE_H__ */
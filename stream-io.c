@@ -0,0 +1,321 @@
+/// stream-io.c
+/// Streaming input and output for evaltp and evalramp, so a plan file with
+/// millions of records can be checked by one process.
+///
+/// Input is text, one record per line, with fields separated by commas,
+/// semicolons or whitespace. Blank lines and lines starting with '#' are
+/// skipped. Output is CSV, or with --binary a packed stream of records, each
+/// four native doubles followed by a native int32 status.
+///
+/// Both directions use large buffers and avoid stdio's per-value overhead:
+/// numbers are parsed by parse_double rather than atof, and the common
+/// integer-valued outputs (N, fs, statuses) are formatted by hand.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stream-io.h"
+
+// Exact powers of ten; every one of them is representable as a double.
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// Parse a decimal number starting at s and set *end past it, like strtod.
+/// Numbers with at most 15 significant digits and a decimal exponent of at
+/// most 22 are converted with a single correctly rounded multiply or divide.
+/// Anything else (long mantissas, huge exponents, inf, nan, hex) is handed
+/// to strtod, so the result is always correctly rounded.
+double parse_double(const char* s, char** end) {
+    const char* p = s;
+    int negative = 0;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    const char* start = p;
+    while (*p >= '0' && *p <= '9') {
+        if (mantissa != 0 || *p != '0') {
+            digits++;
+        }
+        mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+        p++;
+        if (digits > 15) {
+            return strtod(s, end);
+        }
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            if (mantissa != 0 || *p != '0') {
+                digits++;
+            }
+            mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+            exponent--;
+            p++;
+            if (digits > 15) {
+                return strtod(s, end);
+            }
+        }
+    }
+    if (p == start || (p == start + 1 && *start == '.')) {
+        // No digits: inf, nan or not a number at all.
+        return strtod(s, end);
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char* q = p + 1;
+        int exp_negative = 0;
+        int e = 0;
+        if (*q == '-' || *q == '+') {
+            exp_negative = *q == '-';
+            q++;
+        }
+        if (!(*q >= '0' && *q <= '9')) {
+            return strtod(s, end);
+        }
+        while (*q >= '0' && *q <= '9') {
+            e = e * 10 + (*q - '0');
+            q++;
+            if (e > 1000) {
+                return strtod(s, end);
+            }
+        }
+        exponent += exp_negative ? -e : e;
+        p = q;
+    }
+    if (exponent < -22 || exponent > 22) {
+        return strtod(s, end);
+    }
+    double value = (double) mantissa;
+    if (exponent < 0) {
+        value /= pow10_exact[-exponent];
+    }
+    else {
+        value *= pow10_exact[exponent];
+    }
+    *end = (char*) p;
+    return negative ? -value : value;
+}
+
+/// Read records from f through a buffer of size bytes; no line may be longer
+/// than that. Returns 0, or -1 if the buffer can't be allocated.
+int RR_open(RecordReader* rr, FILE* f, size_t size) {
+    rr->buf = malloc(size + 1);
+    if (rr->buf == NULL) {
+        return -1;
+    }
+    rr->f = f;
+    rr->size = size;
+    rr->len = 0;
+    rr->pos = 0;
+    rr->line = 0;
+    rr->eof = 0;
+    rr->buf[0] = '\0';
+    return 0;
+}
+
+// Move the unread bytes to the front of the buffer and read more after them.
+static void RR_fill(RecordReader* rr) {
+    memmove(rr->buf, rr->buf + rr->pos, rr->len - rr->pos);
+    rr->len -= rr->pos;
+    rr->pos = 0;
+    size_t got = fread(rr->buf + rr->len, 1, rr->size - rr->len, rr->f);
+    if (got == 0) {
+        rr->eof = 1;
+    }
+    rr->len += got;
+    rr->buf[rr->len] = '\0';
+}
+
+static int is_separator(char c) {
+    return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r';
+}
+
+/// Parse the next record into values, which holds n doubles.
+/// Returns the number of values on the line (which may be less than n),
+/// RR_MALFORMED if a field on the line is not a number, or RR_END at the end
+/// of the input. Values beyond the first n are ignored.
+int RR_next(RecordReader* rr, double values[], int n) {
+    for (;;) {
+        char* line = rr->buf + rr->pos;
+        char* newline = memchr(line, '\n', rr->len - rr->pos);
+        if (newline == NULL && !rr->eof && rr->len - rr->pos < rr->size) {
+            RR_fill(rr);
+            continue;
+        }
+        if (newline == NULL && rr->pos == rr->len) {
+            return RR_END;
+        }
+        // The final line may lack a newline, and an overlong line is split.
+        char* stop = newline ? newline : rr->buf + rr->len;
+        *stop = '\0';
+        rr->pos = (size_t) (stop - rr->buf) + (newline ? 1 : 0);
+        rr->line++;
+
+        char* p = line;
+        while (is_separator(*p)) {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        int count = 0;
+        while (*p != '\0') {
+            char* end;
+            double v = parse_double(p, &end);
+            if (end == p) {
+                return RR_MALFORMED;
+            }
+            if (count < n) {
+                values[count] = v;
+            }
+            count++;
+            p = end;
+            while (is_separator(*p)) {
+                p++;
+            }
+        }
+        return count;
+    }
+}
+
+void RR_close(RecordReader* rr) {
+    free(rr->buf);
+    rr->buf = NULL;
+}
+
+/// Write records to f through a buffer of size bytes (at least 64).
+/// Returns 0, or -1 if the buffer can't be allocated.
+int RW_open(RecordWriter* rw, FILE* f, size_t size, int binary) {
+    rw->buf = malloc(size);
+    if (rw->buf == NULL) {
+        return -1;
+    }
+    rw->f = f;
+    rw->size = size;
+    rw->len = 0;
+    rw->binary = binary;
+    return 0;
+}
+
+static void RW_flush(RecordWriter* rw) {
+    fwrite(rw->buf, 1, rw->len, rw->f);
+    rw->len = 0;
+}
+
+// Format v into out and return the number of characters. Whole numbers below
+// 2^53 are written digit by digit; everything else with 17 significant digits
+// so the value reads back exactly.
+static int format_double(char* out, double v) {
+    if (v > -9007199254740992.0 && v < 9007199254740992.0 &&
+        v == (double) (int64_t) v && !(v == 0 && 1 / v < 0)) {
+        char digits[20];
+        int n = 0;
+        int len = 0;
+        uint64_t u = v < 0 ? (uint64_t) -v : (uint64_t) v;
+        do {
+            digits[n++] = (char) ('0' + u % 10);
+            u /= 10;
+        } while (u > 0);
+        if (v < 0) {
+            out[len++] = '-';
+        }
+        while (n > 0) {
+            out[len++] = digits[--n];
+        }
+        return len;
+    }
+    return snprintf(out, 32, "%.17g", v);
+}
+
+/// Append one record of n values (n <= 8) and a status.
+void RW_record(RecordWriter* rw, const double values[], int n, int status) {
+    if (rw->size - rw->len < (size_t) (n + 1) * 32) {
+        RW_flush(rw);
+    }
+    char* out = rw->buf + rw->len;
+    if (rw->binary) {
+        int32_t s = status;
+        memcpy(out, values, n * sizeof(double));
+        memcpy(out + n * sizeof(double), &s, sizeof(s));
+        rw->len += n * sizeof(double) + sizeof(s);
+        return;
+    }
+    size_t len = 0;
+    for (int i = 0; i < n; i++) {
+        len += format_double(out + len, values[i]);
+        out[len++] = ',';
+    }
+    len += format_double(out + len, status);
+    out[len++] = '\n';
+    rw->len += len;
+}
+
+void RW_close(RecordWriter* rw) {
+    RW_flush(rw);
+    fflush(rw->f);
+    free(rw->buf);
+    rw->buf = NULL;
+}
+
+#define STREAM_BUFFER (1 << 20)
+
+/// The streaming mode shared by evaltp and evalramp:
+///     PROGRAM [--binary] FILE    (FILE may be - for stdin)
+/// Each record of n_inputs values is passed to resolve, which fills four
+/// outputs and returns a status; the outputs and status are written to
+/// stdout. Malformed lines are reported on stderr and skipped.
+/// Returns the exit code: 0, or 1 if any line was skipped, an option is not
+/// recognized or the input couldn't be read.
+int stream_main(int argc, char const *argv[], int n_inputs,
+                int (*resolve)(const double inputs[], double outputs[])) {
+    int binary = argc > 2 && strcmp(argv[1], "--binary") == 0;
+    const char* path = argv[argc - 1];
+    if (argc < 2 || argc > 3 || (argc == 3 && !binary)
+        || strncmp(path, "--", 2) == 0) {
+        fprintf(stderr, "usage: %s [--binary] FILE    (FILE may be -)\n",
+                argv[0]);
+        return 1;
+    }
+    FILE* in = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return 1;
+    }
+    RecordReader rr;
+    RecordWriter rw;
+    if (RR_open(&rr, in, STREAM_BUFFER) != 0 ||
+        RW_open(&rw, stdout, STREAM_BUFFER, binary) != 0) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    int exit_code = 0;
+    double inputs[8];
+    double outputs[4];
+    int count;
+    while ((count = RR_next(&rr, inputs, 8)) != RR_END) {
+        if (count == RR_MALFORMED) {
+            fprintf(stderr, "line %zu: not a number\n", rr.line);
+            exit_code = 1;
+            continue;
+        }
+        if (count != n_inputs) {
+            fprintf(stderr, "line %zu: expected %d values, got %d\n",
+                    rr.line, n_inputs, count);
+            exit_code = 1;
+            continue;
+        }
+        int status = resolve(inputs, outputs);
+        RW_record(&rw, outputs, 4, status);
+    }
+    RW_close(&rw);
+    RR_close(&rr);
+    if (in != stdin) {
+        fclose(in);
+    }
+    return exit_code;
+}
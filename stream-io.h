@@ -0,0 +1,49 @@
+// Stream IO Header
+// Buffered record input and output for the streaming modes of evaltp and
+// evalramp.
+#ifndef __STREAMIO_H__
+#define __STREAMIO_H__
+
+#include <stdio.h>
+#include <stddef.h>
+
+typedef struct RecordReaders {
+    FILE* f;
+    char* buf;      // Holds len bytes of input plus a terminating NUL.
+    size_t size;
+    size_t len;
+    size_t pos;
+    size_t line;    // Number of the line last returned, for error messages.
+    int eof;
+} RecordReader;
+
+typedef struct RecordWriters {
+    FILE* f;
+    char* buf;
+    size_t size;
+    size_t len;
+    int binary;     // Packed doubles and an int32 status instead of CSV.
+} RecordWriter;
+
+// RR_next results other than a count of values.
+#define RR_END -1           // No more records.
+#define RR_MALFORMED -2     // The line has a field that is not a number.
+
+double parse_double(const char* s, char** end);
+
+int RR_open(RecordReader* rr, FILE* f, size_t size);
+
+int RR_next(RecordReader* rr, double values[], int n);
+
+void RR_close(RecordReader* rr);
+
+int RW_open(RecordWriter* rw, FILE* f, size_t size, int binary);
+
+void RW_record(RecordWriter* rw, const double values[], int n, int status);
+
+void RW_close(RecordWriter* rw);
+
+int stream_main(int argc, char const *argv[], int n_inputs,
+                int (*resolve)(const double inputs[], double outputs[]));
+
+#endif /* __STREAMIO_H__ */
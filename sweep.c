@@ -0,0 +1,175 @@
+/// sweep.c
+/// Multithreaded versions of TP_check_batch and RP_check for sweeps with tens
+/// of millions of points.
+///
+/// The batch is cut into chunks of SWEEP_CHUNK elements and each thread starts
+/// with an equal, contiguous share of them. A thread that runs out of chunks
+/// steals the next chunk from the share of another thread, so threads slowed
+/// down by the OS or by expensive branches don't hold up the rest.
+/// Every element is written in place, by exactly one thread, with the same
+/// function the serial code uses, so the results are identical to (and in
+/// the same order as) a serial run.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "sweep.h"
+
+#define CACHE_LINE 64
+#define MAX_THREADS 256
+
+// One thread's share of the chunks, padded so that the counters of different
+// threads are on different cache lines. Other threads steal from next, so the
+// owner only writes n_errors once, when it is done.
+typedef struct Shares {
+    size_t next;        // Next chunk to take (may run past end).
+    size_t end;
+    int n_errors;
+    char pad[CACHE_LINE - 2 * sizeof(size_t) - sizeof(int)];
+} __attribute__((aligned(CACHE_LINE))) Share;
+
+typedef struct Sweeps Sweep;
+
+struct Sweeps {
+    double* fs;
+    double* dt;
+    double* N;
+    double* T;
+    const double* eps;
+    RampParameter* rp;
+    TimingParameter* tp;
+    int* status;
+    size_t n;
+    int n_threads;
+    int (*run)(Sweep* sweep, size_t begin, size_t end);
+    Share shares[MAX_THREADS];
+};
+
+typedef struct Workers {
+    Sweep* sweep;
+    int id;
+} Worker;
+
+/// Allocate size bytes aligned to a cache line; release with free.
+void* sweep_alloc(size_t size) {
+    void* p;
+    if (posix_memalign(&p, CACHE_LINE, size) != 0) {
+        return NULL;
+    }
+    return p;
+}
+
+static int run_tp(Sweep* s, size_t begin, size_t end) {
+    return TP_check_batch(s->fs + begin, s->dt + begin, s->N + begin,
+                          s->T + begin, s->eps + begin, s->status + begin,
+                          end - begin);
+}
+
+static int run_rp(Sweep* s, size_t begin, size_t end) {
+    int n_errors = 0;
+    for (size_t i = begin; i < end; i++) {
+        s->status[i] = RP_check(&s->rp[i], &s->tp[i]);
+        n_errors += s->status[i] < 0;
+    }
+    return n_errors;
+}
+
+// Take chunks from share until it is empty. Returns the number of errors.
+static int drain(Sweep* s, Share* share) {
+    int n_errors = 0;
+    for (;;) {
+        size_t chunk = __atomic_fetch_add(&share->next, 1, __ATOMIC_RELAXED);
+        if (chunk >= share->end) {
+            return n_errors;
+        }
+        size_t begin = chunk * SWEEP_CHUNK;
+        size_t end = begin + SWEEP_CHUNK < s->n ? begin + SWEEP_CHUNK : s->n;
+        n_errors += s->run(s, begin, end);
+    }
+}
+
+static void* work(void* arg) {
+    Worker* w = arg;
+    Sweep* s = w->sweep;
+    int n_errors = drain(s, &s->shares[w->id]);
+    for (int k = 1; k < s->n_threads; k++) {
+        n_errors += drain(s, &s->shares[(w->id + k) % s->n_threads]);
+    }
+    s->shares[w->id].n_errors = n_errors;
+    return NULL;
+}
+
+// Split the chunks between the threads, run them, and total the errors.
+static int sweep_run(Sweep* s) {
+    size_t n_chunks = (s->n + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    if (s->n_threads < 1) {
+        s->n_threads = 1;
+    }
+    if (s->n_threads > MAX_THREADS) {
+        s->n_threads = MAX_THREADS;
+    }
+    if ((size_t) s->n_threads > n_chunks) {
+        s->n_threads = n_chunks > 0 ? (int) n_chunks : 1;
+    }
+    for (int t = 0; t < s->n_threads; t++) {
+        s->shares[t].next = n_chunks * t / s->n_threads;
+        s->shares[t].end = n_chunks * (t + 1) / s->n_threads;
+        s->shares[t].n_errors = 0;
+    }
+
+    pthread_t threads[MAX_THREADS];
+    Worker workers[MAX_THREADS];
+    int started = 1;
+    for (int t = 0; t < s->n_threads; t++) {
+        workers[t].sweep = s;
+        workers[t].id = t;
+    }
+    // The calling thread is worker 0. If a thread can't be started, its
+    // share is stolen by the others.
+    for (int t = 1; t < s->n_threads; t++) {
+        if (pthread_create(&threads[t], NULL, work, &workers[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+    work(&workers[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    int n_errors = 0;
+    for (int t = 0; t < s->n_threads; t++) {
+        n_errors += s->shares[t].n_errors;
+    }
+    return n_errors;
+}
+
+/// TP_check_batch on n_threads threads. Returns the number of elements with
+/// a status < 0.
+int TP_check_parallel(double* fs, double* dt, double* N, double* T,
+                      const double* eps, int* status, size_t n, int n_threads) {
+    Sweep s = {0};
+    s.fs = fs;
+    s.dt = dt;
+    s.N = N;
+    s.T = T;
+    s.eps = eps;
+    s.status = status;
+    s.n = n;
+    s.n_threads = n_threads;
+    s.run = run_tp;
+    return sweep_run(&s);
+}
+
+/// RP_check(&rp[i], &tp[i]) for every i on n_threads threads, with the
+/// statuses stored in status. Returns the number of statuses < 0.
+int RP_check_parallel(RampParameter* rp, TimingParameter* tp, int* status,
+                      size_t n, int n_threads) {
+    Sweep s = {0};
+    s.rp = rp;
+    s.tp = tp;
+    s.status = status;
+    s.n = n;
+    s.n_threads = n_threads;
+    s.run = run_rp;
+    return sweep_run(&s);
+}
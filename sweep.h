@@ -0,0 +1,23 @@
+// Sweep Header
+// Resolve very large batches of parameters on several threads.
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <stddef.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+// Elements per unit of work. A multiple of 16, so with 64 byte aligned arrays
+// (see sweep_alloc) no two threads ever write to the same cache line.
+#define SWEEP_CHUNK 4096
+
+TIMING_API void* sweep_alloc(size_t size);
+
+TIMING_API int TP_check_parallel(double* fs, double* dt, double* N, double* T,
+                                 const double* eps, int* status, size_t n,
+                                 int n_threads);
+
+TIMING_API int RP_check_parallel(RampParameter* rp, TimingParameter* tp,
+                                 int* status, size_t n, int n_threads);
+
+#endif /* __SWEEP_H__ */
@@ -1,7 +1,26 @@
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "minunit.h"
 #include "check-timing.h"
+#include "simd.h"
 #include "ramp.h"
+#include "sequence.h"
+#include "sample-clock.h"
+#include "resolve-cache.h"
+#include "pool.h"
+#include "stream-io.h"
+#include "sweep.h"
+#include "grid.h"
+#include "ring.h"
+#include "wavefile.h"
+#include "exact-timing.h"
+#include "timing-editor.h"
+#include "instrument.h"
+#include "dac.h"
+#include "ramp-shape.h"
+#include "solve.h"
 
 // A helper function to debug a TimingParameter using minunit.
 void check_tp_state(TimingParameter* tp, double expected[]) {
@@ -26,6 +45,35 @@ MU_TEST(test_TP_init) {
     free(tp);
 }
 
+// Test initializing caller-owned and pooled parameters.
+MU_TEST(test_init_inplace) {
+    TimingParameter tp;
+    TP_init_inplace(&tp, 25.0, 0.04, 100, 4);
+    double expected[] = {25, 0.04, 100, 4};
+    check_tp_state(&tp, expected);
+    mu_assert_double_eq(0.1, tp.eps);
+
+    RampParameter rp;
+    RP_init_inplace(&rp, 0, 10, 2, 0.01);
+    double expected_rp[] = {0, 10, 2, 0.01};
+    check_rp_state(&rp, expected_rp);
+    mu_assert_double_eq(0.001, rp.y_Delta_min);
+
+    ParameterPool* pool = PP_create(2);
+    TimingParameter* tp1 = PP_tp(pool, 0, 0, 0, 0);
+    TimingParameter* tp2 = PP_tp(pool, 25.0, 0.04, 100, 4);
+    RampParameter* rp1 = PP_rp(pool, 0, 10, 2, 0.01);
+    mu_check(PP_tp(pool, 1, 0, 0, 0) == NULL);
+    check_tp_state(tp2, expected);
+    mu_assert_int_eq(0, RP_check(rp1, tp1));
+    double tp_exp[] = {200, 0.005, 1000, 5};
+    check_tp_state(tp1, tp_exp);
+
+    PP_reset(pool);
+    mu_check(PP_tp(pool, 1, 0, 0, 0) == tp1);
+    PP_free(pool);
+}
+
 // Test fs_dt_consistent with a number of test cases.
 MU_TEST(test_fs_dt_consistent) {
     int status;
@@ -111,6 +159,153 @@ MU_TEST(test_TP_check){
     mu_assert_int_eq(-1, status);
 }
 
+// Test that TP_check_batch matches TP_check element by element.
+MU_TEST(test_TP_check_batch) {
+    double fs[] = {2, 100, 0, 250, 0, 0, 25, 10};
+    double dt[] = {0.5, 0, 0.1, 0, 0, 0, 0.04, 0.2};
+    double N[] = {0, 10, 10, 500, 10, 100, 100, 0};
+    double T[] = {0, 0, 0, 0, 0, 4, 4, 3};
+    double eps[] = {0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1};
+    int status[8];
+    int n_errors_expected = 0;
+    TimingParameter expected[8];
+    int status_expected[8];
+    for (int i = 0; i < 8; i++) {
+        TimingParameter tp = {fs[i], dt[i], N[i], T[i], eps[i]};
+        status_expected[i] = TP_check(&tp);
+        n_errors_expected += status_expected[i] < 0;
+        expected[i] = tp;
+    }
+
+    int n_errors = TP_check_batch(fs, dt, N, T, eps, status, 8);
+    mu_assert_int_eq(n_errors_expected, n_errors);
+    for (int i = 0; i < 8; i++) {
+        double state[] = {fs[i], dt[i], N[i], T[i]};
+        check_tp_state(&expected[i], state);
+        mu_assert_int_eq(status_expected[i], status[i]);
+    }
+}
+
+// Pick a field value that lands in every branch of fs_dt_consistent and
+// N_T_consistent, including values whose reciprocal overflows or underflows.
+static double random_field(void) {
+    static const double special[] = {
+        0, -1, 1, 0.5, 2, 1e-310, 1e308, 1e-300, 1e300, 4503599627370495.5,
+        1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, -0.0
+    };
+    int r = rand() % 4;
+    if (r == 0) {
+        return 0;
+    }
+    if (r == 1) {
+        return special[rand() % (sizeof(special) / sizeof(special[0]))];
+    }
+    return (double) rand() / RAND_MAX * pow(10, rand() % 13 - 6);
+}
+
+// Test that each batch kernel is bit-for-bit identical to calling
+// fs_dt_consistent and N_T_consistent on each element.
+MU_TEST(test_TP_check_batch_simd) {
+    enum { n = 1027 };
+    static double fs[n], dt[n], N[n], T[n], eps[n];
+    static TimingParameter expected[n];
+    static int status[n], status_expected[n];
+    srand(12345);
+    for (int i = 0; i < n; i++) {
+        TimingParameter tp = {random_field(), random_field(), random_field(),
+                              random_field(), 0.1};
+        expected[i] = tp;
+        fs_dt_consistent(&expected[i]);
+        status_expected[i] = N_T_consistent(&expected[i]);
+    }
+
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+        if (simd_set_level(level) != level) {
+            continue;
+        }
+        srand(12345);
+        for (int i = 0; i < n; i++) {
+            fs[i] = random_field();
+            dt[i] = random_field();
+            N[i] = random_field();
+            T[i] = random_field();
+            eps[i] = 0.1;
+        }
+        TP_check_batch(fs, dt, N, T, eps, status, n);
+        for (int i = 0; i < n; i++) {
+            mu_check(memcmp(&fs[i], &expected[i].fs, sizeof(double)) == 0);
+            mu_check(memcmp(&dt[i], &expected[i].dt, sizeof(double)) == 0);
+            mu_check(memcmp(&N[i], &expected[i].N, sizeof(double)) == 0);
+            mu_check(memcmp(&T[i], &expected[i].T, sizeof(double)) == 0);
+            mu_assert_int_eq(status_expected[i], status[i]);
+        }
+    }
+    simd_set_level(-1);
+}
+
+// A random field that is defined (> 0) or not, as asked.
+static double random_defined(int defined) {
+    double x;
+    do {
+        x = random_field();
+    } while ((x > 0) != defined);
+    return x;
+}
+
+// Test that the fixed-pattern resolvers match TP_check, edge cases included.
+MU_TEST(test_TP_check_batch_fixed) {
+    enum { n = 515 };
+    static const unsigned patterns[] = {
+        TP_PATTERN_FS | TP_PATTERN_N, TP_PATTERN_FS | TP_PATTERN_T,
+        TP_PATTERN_DT | TP_PATTERN_N, TP_PATTERN_DT | TP_PATTERN_T,
+        TP_PATTERN_N | TP_PATTERN_T, TP_PATTERN_FS | TP_PATTERN_DT | TP_PATTERN_N
+    };
+    static double fs[n], dt[n], N[n], T[n], eps[n];
+    static TimingParameter input[n], expected[n];
+    static int status[n], status_expected[n];
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        unsigned pattern = patterns[p];
+        int n_errors = 0;
+        for (int i = 0; i < n; i++) {
+            TP_init_inplace(&input[i],
+                            random_defined((pattern & TP_PATTERN_FS) != 0),
+                            random_defined((pattern & TP_PATTERN_DT) != 0),
+                            random_defined((pattern & TP_PATTERN_N) != 0),
+                            random_defined((pattern & TP_PATTERN_T) != 0));
+            expected[i] = input[i];
+            status_expected[i] = TP_check(&expected[i]);
+            n_errors += status_expected[i] < 0;
+        }
+        for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+            if (simd_set_level(level) != level) {
+                continue;
+            }
+            for (int i = 0; i < n; i++) {
+                fs[i] = input[i].fs;
+                dt[i] = input[i].dt;
+                N[i] = input[i].N;
+                T[i] = input[i].T;
+                eps[i] = input[i].eps;
+            }
+            mu_assert_int_eq(pattern, TP_batch_pattern(fs, dt, N, T, n));
+            mu_assert_int_eq(n_errors,
+                TP_check_batch_fixed(fs, dt, N, T, eps, status, n));
+            for (int i = 0; i < n; i++) {
+                mu_check(memcmp(&fs[i], &expected[i].fs, sizeof(double)) == 0);
+                mu_check(memcmp(&dt[i], &expected[i].dt, sizeof(double)) == 0);
+                mu_check(memcmp(&N[i], &expected[i].N, sizeof(double)) == 0);
+                mu_check(memcmp(&T[i], &expected[i].T, sizeof(double)) == 0);
+                mu_assert_int_eq(status_expected[i], status[i]);
+            }
+        }
+    }
+    simd_set_level(-1);
+    fs[0] = 0;
+    dt[0] = 0.1;
+    fs[1] = 10;
+    dt[1] = 0;
+    mu_assert_int_eq(TP_PATTERN_MIXED, TP_batch_pattern(fs, dt, N, T, 2));
+}
 
 MU_TEST(test_RP_check) {
     int status;
@@ -148,12 +343,1035 @@ MU_TEST(test_RP_check) {
 
 }
 
+// Test that RP_fill produces the ramp from yi to yf, and that every SIMD
+// level writes the same samples and DAC codes.
+MU_TEST(test_RP_fill) {
+    enum { n = 1001 };
+    static double y[n], y_scalar[n];
+    static int16_t codes[n], codes_scalar[n];
+    TimingParameter* tp = TP_init(0, 0, 0, 0);
+    RampParameter* rp = RP_init(-10, 10, 4, 0.02);
+    mu_assert_int_eq(0, RP_check(rp, tp));
+    mu_assert_double_eq(1000, tp->N);
+
+    mu_assert_int_eq(-1, RP_fill(rp, tp, y, codes, 3276.7, 0, 999));
+
+    simd_set_level(SIMD_SCALAR);
+    mu_assert_int_eq(0, RP_fill(rp, tp, y_scalar, codes_scalar, 3276.7, 0, n));
+    mu_assert_double_eq(-10, y_scalar[0]);
+    mu_assert_double_eq(10, y_scalar[999]);
+    mu_assert_double_eq(-10 + 500 * 20.0 / 999, y_scalar[500]);
+    mu_assert_int_eq(-32767, codes_scalar[0]);
+    mu_assert_int_eq(32767, codes_scalar[999]);
+
+    for (int level = SIMD_SSE2; level <= SIMD_AVX2; level++) {
+        if (simd_set_level(level) != level) {
+            continue;
+        }
+        memset(y, 0, sizeof(y));
+        memset(codes, 0, sizeof(codes));
+        mu_assert_int_eq(0, RP_fill(rp, tp, y, codes, 3276.7, 0, n));
+        mu_check(memcmp(y, y_scalar, 1000 * sizeof(double)) == 0);
+        mu_check(memcmp(codes, codes_scalar, 1000 * sizeof(int16_t)) == 0);
+    }
+    simd_set_level(-1);
+
+    // A range must lie within a ramp of at least 2 points.
+    y[0] = 42;
+    mu_assert_int_eq(-1, ramp_fill_range(rp, 1, 0, 1, y, NULL, 1, 0));
+    mu_assert_int_eq(-1, ramp_fill_range(rp, 0, 0, 0, y, NULL, 1, 0));
+    mu_assert_int_eq(-1, ramp_fill_range(rp, 1000, 990, 11, y, NULL, 1, 0));
+    mu_assert_int_eq(-1, ramp_fill_range(rp, 1000, SIZE_MAX, 2, y, NULL, 1, 0));
+    mu_assert_double_eq(42, y[0]);
+    mu_assert_int_eq(0, ramp_fill_range(rp, 1000, 990, 10, y, NULL, 1, 0));
+    mu_assert_double_eq(10, y[9]);
+    free(tp);
+    free(rp);
+}
+
+// Test that streaming a ramp in chunks reproduces RP_fill exactly.
+MU_TEST(test_RS_next) {
+    enum { n = 1000, chunk = 64 };
+    static double y[n], y_chunk[chunk];
+    static int16_t codes[n], codes_chunk[chunk];
+    TimingParameter* tp = TP_init(0, 0, 0, 0);
+    RampParameter* rp = RP_init(-10, 10, 4, 0.02);
+    RampStream rs;
+    RP_check(rp, tp);
+    RP_fill(rp, tp, y, codes, 3276.7, 0, n);
+
+    mu_assert_int_eq(-1, RS_init(&rs, rp, tp, 0, 3276.7, 0));
+    mu_assert_int_eq(0, RS_init(&rs, rp, tp, chunk, 3276.7, 0));
+    size_t total = 0;
+    size_t count;
+    while ((count = RS_next(&rs, y_chunk, codes_chunk)) > 0) {
+        mu_check(memcmp(y_chunk, y + total, count * sizeof(double)) == 0);
+        mu_check(memcmp(codes_chunk, codes + total,
+                        count * sizeof(int16_t)) == 0);
+        total += count;
+    }
+    mu_assert_int_eq(n, total);
+    mu_assert_double_eq(10, y_chunk[n % chunk - 1]);
+
+    RS_seek(&rs, 10 * chunk);
+    mu_assert_int_eq(chunk, RS_next(&rs, y_chunk, NULL));
+    mu_check(memcmp(y_chunk, y + 10 * chunk, chunk * sizeof(double)) == 0);
+    free(tp);
+    free(rp);
+}
+
+// Test that SEQ_plan runs every segment at the fastest ramp's sample rate.
+MU_TEST(test_SEQ_plan) {
+    Segment segments[4] = {
+        {.kind = SEG_RAMP, .rp = {0, 10, 2, 0.01, 0.001}},  // 200 Hz, 5 s
+        {.kind = SEG_HOLD, .T = 0.5},
+        {.kind = SEG_RAMP, .rp = {10, 9, 1, 0.01, 0.001}},  // 100 Hz, 1 s
+        {.kind = SEG_STEP, .y = -1, .T = 0.1},
+    };
+    Sequence seq = {segments, 4, 0, {0, 0, 0, 0, 0.1}};
+    static double y[1321];
+
+    mu_assert_int_eq(0, SEQ_plan(&seq));
+    double tp_exp[] = {200, 0.005, 1320, 6.6};
+    check_tp_state(&seq.tp, tp_exp);
+    mu_assert_int_eq(1000, segments[0].N);
+    mu_assert_int_eq(100, segments[1].N);
+    mu_assert_int_eq(200, segments[2].N);
+    mu_assert_int_eq(20, segments[3].N);
+    mu_assert_int_eq(1300, segments[3].offset);
+
+    mu_assert_int_eq(-1, SEQ_render(&seq, y, 1319));
+    mu_assert_int_eq(0, SEQ_render(&seq, y, 1321));
+    mu_assert_double_eq(0, y[0]);
+    mu_assert_double_eq(10, y[999]);
+    mu_assert_double_eq(10, y[1099]);
+    mu_assert_double_eq(10, y[1100]);
+    mu_assert_double_eq(9, y[1299]);
+    mu_assert_double_eq(-1, y[1319]);
+}
+
+// Test that a ramp giving only its rate or only its resolution is timed by
+// the sequence's clock.
+MU_TEST(test_SEQ_plan_clocked) {
+    Segment segments[3] = {
+        {.kind = SEG_RAMP, .rp = {0, 1, 0, 0.01, 0.001}},   // 100 points
+        {.kind = SEG_HOLD, .T = 0.05},
+        {.kind = SEG_RAMP, .rp = {1, 0, 10, 0, 0.001}},     // 0.1 s
+    };
+    Sequence seq = {segments, 3, 0, {1000, 0, 0, 0, 0.1}};
+
+    mu_assert_int_eq(0, SEQ_plan(&seq));
+    double tp_exp[] = {1000, 0.001, 250, 0.25};
+    check_tp_state(&seq.tp, tp_exp);
+    mu_assert_int_eq(100, segments[0].N);
+    mu_assert_int_eq(50, segments[1].N);
+    mu_assert_int_eq(100, segments[2].N);
+
+    // Without a clock neither ramp fixes a sample rate.
+    seq.tp.fs = 0;
+    mu_assert_int_eq(-1, SEQ_plan(&seq));
+}
+
+// Test that TP_check_hw snaps fs to timebase / divisor.
+MU_TEST(test_TP_check_hw) {
+    SampleClock sc;
+    uint32_t divisor;
+    mu_assert_int_eq(-1, SC_init(&sc, 1e6, 0, 10));
+    // A failed SC_init leaves a clock without rates.
+    TimingParameter tp_empty = {300e3, 0, 1000, 0, 0.1};
+    mu_assert_double_eq(0, SC_coerce(&sc, 300e3, &divisor));
+    mu_assert_double_eq(0, SC_floor(&sc, 300e3, &divisor));
+    mu_assert_int_eq(-1, TP_check_hw(&tp_empty, &sc));
+    mu_assert_double_eq(300e3, tp_empty.fs);
+    mu_assert_int_eq(0, SC_init(&sc, 1e6, 2, 1000000));
+
+    mu_assert_double_eq(1e6 / 3, SC_coerce(&sc, 300e3, &divisor));
+    mu_assert_int_eq(3, divisor);
+    mu_assert_double_eq(1e6 / 2, SC_coerce(&sc, 2e6, &divisor));
+    mu_assert_int_eq(2, divisor);
+    mu_assert_double_eq(1, SC_coerce(&sc, 0.1, &divisor));
+    mu_assert_int_eq(1000000, divisor);
+    // Rates that fall exactly on a divisor, and the nearest one in rate,
+    // not in divisor: 1e6 / 2.5 is closer to 1e6 / 3 than to 1e6 / 2.
+    mu_assert_double_eq(1e6 / 7, SC_coerce(&sc, 1e6 / 7, &divisor));
+    mu_assert_int_eq(7, divisor);
+    mu_assert_double_eq(1e6 / 3, SC_coerce(&sc, 4e5, &divisor));
+    mu_assert_int_eq(3, divisor);
+    mu_assert_double_eq(1e6 / 7, SC_floor(&sc, 1e6 / 7, &divisor));
+    mu_assert_int_eq(7, divisor);
+    mu_assert_double_eq(1e6 / 8, SC_floor(&sc, 1e6 / 7 - 1e-9, &divisor));
+    mu_assert_int_eq(8, divisor);
+    mu_assert_double_eq(1e6 / 3, SC_rate(&sc, sc.n_rates - 2));
+
+    // A 32 bit counter: every divisor, with no table to allocate.
+    SampleClock counter;
+    mu_assert_int_eq(0, SC_init(&counter, 100e6, 1, UINT32_MAX));
+    mu_check(counter.n_rates == UINT32_MAX);
+    mu_assert_double_eq(100e6 / UINT32_MAX, SC_coerce(&counter, 0, &divisor));
+    mu_check(divisor == UINT32_MAX);
+    mu_assert_double_eq(100e6 / 4294961, SC_coerce(&counter, 23.2831, &divisor));
+    mu_check(divisor == 4294961);
+    mu_assert_double_eq(0, SC_floor(&counter, 0.02, NULL));
+    SC_free(&counter);
+
+    // N given: keep it, and T becomes the real duration.
+    TimingParameter tp_N = {300e3, 0, 1000, 0, 0.1};
+    mu_assert_int_eq(0, TP_check_hw(&tp_N, &sc));
+    double expected_N[] = {1e6 / 3, 3e-6, 1000, 3e-3};
+    check_tp_state(&tp_N, expected_N);
+
+    // Only T given: recompute N at the coerced rate.
+    TimingParameter tp_T = {0, 3.3e-6, 0, 0.01, 0.1};
+    mu_assert_int_eq(0, TP_check_hw(&tp_T, &sc));
+    double expected_T[] = {1e6 / 3, 3e-6, 3333, 9.999e-3};
+    check_tp_state(&tp_T, expected_T);
+
+    TimingParameter tp_bad = {300e3, 0, 0, 0, 0.1};
+    mu_assert_int_eq(-1, TP_check_hw(&tp_bad, &sc));
+    SC_free(&sc);
+}
+
+// Test that the cache returns what TP_check and RP_check would, and counts
+// hits and misses.
+MU_TEST(test_resolve_cache) {
+    ResolveCache rc;
+    mu_assert_int_eq(0, RC_init(&rc, 3));
+    mu_assert_int_eq(3, rc.mask);
+
+    for (int i = 0; i < 3; i++) {
+        TimingParameter tp = {100, 0, 10, 0, 0.1};
+        mu_assert_int_eq(0, RC_TP_check(&rc, &tp));
+        double expected[] = {100, 0.01, 10, 0.1};
+        check_tp_state(&tp, expected);
+
+        TimingParameter tp_bad = {0, 0, 10, 0, 0.1};
+        mu_assert_int_eq(-1, RC_TP_check(&rc, &tp_bad));
+
+        TimingParameter tp_ramp = {0, 0, 0, 0, 0.1};
+        RampParameter rp = {0, 10, 2, 0.01, 0.001};
+        mu_assert_int_eq(0, RC_RP_check(&rc, &rp, &tp_ramp));
+        double expected_ramp[] = {200, 0.005, 1000, 5};
+        check_tp_state(&tp_ramp, expected_ramp);
+    }
+    mu_assert_int_eq(3, rc.misses);
+    mu_assert_int_eq(6, rc.hits);
+
+    // More distinct inputs than slots: entries are replaced, results stay right.
+    for (int i = 1; i <= 100; i++) {
+        TimingParameter tp = {i, 0, 0, 1, 0.1};
+        mu_assert_int_eq(0, RC_TP_check(&rc, &tp));
+        mu_assert_double_eq(i, tp.N);
+    }
+    RC_clear(&rc);
+    mu_assert_int_eq(0, rc.hits);
+    RC_free(&rc);
+}
+
+// Test that parse_double agrees exactly with strtod.
+MU_TEST(test_parse_double) {
+    static const char* inputs[] = {
+        "0", "-0", "10", "0.1", "-2.5e-3", "1.5E3", "+7", "123456789012345",
+        "1234567890123456789", "0.000000000000000000000000001", "1e308",
+        "4e-320", "9007199254740993", "inf", "-nan", ".5", "5.", "1e", "abc"
+    };
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        char* end;
+        char* end_expected;
+        double v = parse_double(inputs[i], &end);
+        double expected = strtod(inputs[i], &end_expected);
+        mu_check(memcmp(&v, &expected, sizeof(double)) == 0 || v != v);
+        mu_check(end == end_expected);
+    }
+}
+
+// Test that RR_next skips comments and rejects a line with a stray field.
+MU_TEST(test_record_reader) {
+    FILE* f = tmpfile();
+    mu_check(f != NULL);
+    fputs("# fs dt N T\n1 2 3 4 abc\n\n5,6;7 8\n9 10\n", f);
+    rewind(f);
+    RecordReader rr;
+    double values[4];
+    mu_assert_int_eq(0, RR_open(&rr, f, 64));
+    mu_assert_int_eq(RR_MALFORMED, RR_next(&rr, values, 4));
+    mu_assert_int_eq(2, rr.line);
+    mu_assert_int_eq(4, RR_next(&rr, values, 4));
+    mu_assert_int_eq(4, rr.line);
+    mu_assert_double_eq(8, values[3]);
+    mu_assert_int_eq(2, RR_next(&rr, values, 4));
+    mu_assert_int_eq(RR_END, RR_next(&rr, values, 4));
+    RR_close(&rr);
+    fclose(f);
+}
+
+// Test that the parallel sweeps give the serial results, in order.
+MU_TEST(test_check_parallel) {
+    enum { n = 5 * SWEEP_CHUNK + 123 };
+    double* fs = sweep_alloc(4 * n * sizeof(double));
+    double* dt = fs + n;
+    double* N = dt + n;
+    double* T = N + n;
+    static double eps[n];
+    static int status[n];
+    static TimingParameter tp[n], tp_serial[n];
+    static RampParameter rp[n];
+    srand(2014);
+    for (int i = 0; i < n; i++) {
+        TP_init_inplace(&tp_serial[i], random_field(), random_field(),
+                        random_field(), random_field());
+        fs[i] = tp_serial[i].fs;
+        dt[i] = tp_serial[i].dt;
+        N[i] = tp_serial[i].N;
+        T[i] = tp_serial[i].T;
+        eps[i] = tp_serial[i].eps;
+        RP_init_inplace(&rp[i], random_field(), random_field(), random_field(),
+                        random_field());
+    }
+    // The serial reference: TP_check_batch on a copy of the inputs.
+    double* batch = sweep_alloc(4 * n * sizeof(double));
+    memcpy(batch, fs, 4 * n * sizeof(double));
+    static int batch_status[n];
+    int n_errors = TP_check_batch(batch, batch + n, batch + 2 * n,
+                                  batch + 3 * n, eps, batch_status, n);
+    for (int i = 0; i < n; i++) {
+        tp[i] = tp_serial[i];
+    }
+
+    mu_assert_int_eq(n_errors, TP_check_parallel(fs, dt, N, T, eps, status, n, 4));
+    mu_check(memcmp(fs, batch, 4 * n * sizeof(double)) == 0);
+    mu_check(memcmp(status, batch_status, sizeof(status)) == 0);
+    free(batch);
+
+    static int rp_status[n];
+    n_errors = 0;
+    for (int i = 0; i < n; i++) {
+        tp_serial[i] = tp[i];
+        rp_status[i] = RP_check(&rp[i], &tp_serial[i]);
+        n_errors += rp_status[i] < 0;
+    }
+    mu_assert_int_eq(n_errors, RP_check_parallel(rp, tp, status, n, 3));
+    for (int i = 0; i < n; i++) {
+        mu_check(memcmp(&tp[i], &tp_serial[i], sizeof(TimingParameter)) == 0);
+        mu_assert_int_eq(rp_status[i], status[i]);
+    }
+    free(fs);
+}
+
+// Test random access into a grid sweep, and filtering it by status.
+MU_TEST(test_grid_sweep) {
+    GridSweep gs;
+    TimingParameter base = {0, 0, 0, 0, 0.1};
+    TimingParameter tp;
+    RampParameter rp;
+    static const double N_values[] = {0, 10, 100};
+    GS_init(&gs, &base, NULL);
+    mu_assert_int_eq(-1, GS_add_axis(&gs, GRID_DYDT, GRID_LINEAR, 0, 1, NULL, 2));
+    mu_assert_int_eq(-1, GS_add_axis(&gs, GRID_FS, GRID_LOG, 0, 1e6, NULL, 4));
+    mu_assert_int_eq(0, GS_add_axis(&gs, GRID_FS, GRID_LOG, 1e3, 1e6, NULL, 4));
+    mu_assert_int_eq(0, GS_add_axis(&gs, GRID_N, GRID_LIST, 0, 0, N_values, 3));
+    mu_assert_int_eq(12, gs.n_points);
+
+    // Point 10 is fs = 1e6 (index 3), N = 10 (index 1).
+    mu_assert_int_eq(0, GS_point(&gs, 10, &tp, &rp));
+    double expected[] = {1e6, 1e-6, 10, 1e-5};
+    check_tp_state(&tp, expected);
+    mu_assert_int_eq(0, GS_point(&gs, 8, &tp, &rp));
+    mu_check(fabs(tp.fs / 1e5 - 1) < 1e-12);
+    mu_assert_int_eq(GRID_OUT_OF_RANGE, GS_point(&gs, 12, &tp, &rp));
+
+    // N = 0 leaves the point underdetermined.
+    int status;
+    mu_check(GS_next(&gs, 1, GS_STATUS_BIT(-1), &tp, &rp, &status) == 3);
+    mu_assert_int_eq(-1, status);
+    mu_check(GS_next(&gs, 10, GS_STATUS_BIT(-1), &tp, &rp, &status) == 12);
+
+    // Indices past INT64_MAX come back intact.
+    GS_init(&gs, &base, NULL);
+    mu_assert_int_eq(0, GS_add_axis(&gs, GRID_FS, GRID_LINEAR, 1, 2, NULL,
+                                    1ULL << 32));
+    mu_assert_int_eq(0, GS_add_axis(&gs, GRID_N, GRID_LINEAR, 1, 2, NULL,
+                                    (1ULL << 32) - 1));
+    uint64_t far = (1ULL << 63) + 5;
+    mu_check(GS_next(&gs, far, GS_STATUS_BIT(0), &tp, &rp, &status) == far);
+    mu_assert_int_eq(0, status);
+
+    // A ramp sweep over ramp rates.
+    RampParameter base_rp = {0, 10, 0, 0.01, 0.001};
+    GS_init(&gs, &base, &base_rp);
+    mu_assert_int_eq(0, GS_add_axis(&gs, GRID_DYDT, GRID_LINEAR, 1, 4, NULL, 4));
+    mu_assert_int_eq(0, GS_point(&gs, 1, &tp, &rp));
+    double expected_rp[] = {200, 0.005, 1000, 5};
+    check_tp_state(&tp, expected_rp);
+}
+
+// A stand-in for the DAQ write call: append the samples to a buffer.
+typedef struct Captures {
+    double* y;
+    size_t len;
+} Capture;
+
+static int capture_samples(const double* samples, size_t count, void* context) {
+    Capture* capture = context;
+    memcpy(capture->y + capture->len, samples, count * sizeof(double));
+    capture->len += count;
+    return 0;
+}
+
+// A writer that records how full the ring was when writing started.
+typedef struct Primings {
+    SampleRing* ring;
+    size_t calls;
+    size_t fill;
+} Priming;
+
+static int record_priming(const double* samples, size_t count, void* context) {
+    (void) samples;
+    (void) count;
+    Priming* priming = context;
+    if (priming->calls++ == 0) {
+        priming->fill = priming->ring->producer.head
+                        - priming->ring->consumer.tail;
+    }
+    return 0;
+}
+
+// Test that a ramp passed through the ring arrives complete and in order.
+MU_TEST(test_sample_ring) {
+    enum { n = 1000, block = 64 };
+    static double y[n], y_ring[n];
+    TimingParameter tp = {0, 0, 0, 0, 0.1};
+    RampParameter rp = {-10, 10, 4, 0.02, 0.001};
+    RampStream rs;
+    SampleRing ring;
+    Capture capture = {y_ring, 0};
+    RP_check(&rp, &tp);
+    RP_fill(&rp, &tp, y, NULL, 1, 0, n);
+
+    mu_assert_int_eq(0, SR_init(&ring, 3, block));
+    mu_assert_int_eq(4, ring.n_blocks);
+    mu_assert_int_eq(0, RS_init(&rs, &rp, &tp, block, 1, 0));
+    mu_assert_int_eq(0, SR_run_ramp(&ring, &rs, capture_samples, &capture));
+    mu_assert_int_eq(n, capture.len);
+    mu_check(memcmp(y, y_ring, sizeof(y)) == 0);
+    mu_assert_int_eq((n + block - 1) / block, ring.consumer.n_blocks);
+    mu_check(ring.consumer.latency_min <= ring.consumer.latency_max);
+    // A second run on the same ring primes it again before writing.
+    Priming priming = {&ring, 0, 0};
+    mu_assert_int_eq(0, RS_init(&rs, &rp, &tp, block, 1, 0));
+    mu_assert_int_eq(0, SR_run_ramp(&ring, &rs, record_priming, &priming));
+    mu_assert_int_eq((n + block - 1) / block, priming.calls);
+    mu_assert_int_eq(ring.n_blocks, priming.fill);
+
+    // The ring can also be driven by hand.
+    RingBlock* b = SR_producer_block(&ring);
+    b->count = 1;
+    b->samples[0] = 42;
+    SR_publish(&ring);
+    b = SR_consumer_block(&ring);
+    mu_assert_double_eq(42, b->samples[0]);
+    SR_release(&ring);
+    mu_check(SR_consumer_block(&ring) == NULL);
+    SR_free(&ring);
+
+    // Running dry mid-stream is one underrun however often the writer
+    // polls; a full ring is a stall, counted once per wait.
+    mu_assert_int_eq(0, SR_init(&ring, 2, block));
+    for (int i = 0; i < 3; i++) {
+        mu_check(SR_consumer_block(&ring) == NULL);
+    }
+    for (int i = 0; i < 2; i++) {
+        SR_producer_block(&ring)->count = 1;
+        SR_publish(&ring);
+    }
+    mu_check(SR_producer_block(&ring) == NULL);
+    mu_check(SR_producer_block(&ring) == NULL);
+    mu_check(SR_consumer_block(&ring) != NULL);
+    SR_release(&ring);
+    mu_assert_int_eq(1, ring.consumer.underruns);
+    mu_assert_int_eq(1, ring.producer.stalls);
+    // An empty ring after SR_finish is not a gap.
+    mu_check(SR_consumer_block(&ring) != NULL);
+    SR_release(&ring);
+    SR_finish(&ring);
+    mu_check(SR_consumer_block(&ring) == NULL);
+    mu_assert_int_eq(1, ring.consumer.underruns);
+    SR_free(&ring);
+}
+
+#ifndef _WIN32
+// Test writing a ramp to a waveform file and mapping it back.
+MU_TEST(test_wavefile) {
+    enum { n = 1000 };
+    static double y[n];
+    static int16_t codes[n];
+    const char* path = "test_waveform.bin";
+    TimingParameter tp = {0, 0, 0, 0, 0.1};
+    TimingParameter tp_read;
+    RampParameter rp = {-10, 10, 4, 0.02, 0.001};
+    RampParameter rp_read;
+    WaveFile wf;
+    RP_check(&rp, &tp);
+    RP_fill(&rp, &tp, y, codes, 3276.7, 0, n);
+
+    mu_assert_int_eq(0, WF_write_ramp(path, &rp, &tp, WF_DOUBLE, 1, 0));
+    mu_assert_int_eq(0, WF_open(&wf, path));
+    mu_assert_int_eq(n, wf.header->n_samples);
+    mu_assert_int_eq(WF_DOUBLE, wf.header->sample_type);
+    WF_parameters(&wf, &rp_read, &tp_read);
+    double tp_exp[] = {200, 0.005, 1000, 5};
+    double rp_exp[] = {-10, 10, 4, 0.02};
+    check_tp_state(&tp_read, tp_exp);
+    check_rp_state(&rp_read, rp_exp);
+    mu_check(memcmp(wf.data, y, sizeof(y)) == 0);
+    WF_close(&wf);
+
+    mu_assert_int_eq(0, WF_write_ramp(path, &rp, &tp, WF_INT16, 3276.7, 0));
+    mu_assert_int_eq(0, WF_open(&wf, path));
+    mu_assert_int_eq(WF_INT16, wf.header->sample_type);
+    mu_assert_double_eq(3276.7, wf.header->scale);
+    mu_check(memcmp(wf.data, codes, sizeof(codes)) == 0);
+    WF_close(&wf);
+
+    // Not a waveform file.
+    FILE* f = fopen(path, "w");
+    fprintf(f, "fs,dt,N,T\n");
+    fclose(f);
+    mu_assert_int_eq(-1, WF_open(&wf, path));
+    unlink(path);
+}
+
+#endif
+
+// Test the exact resolver, including a case where doubles round N wrongly.
+MU_TEST(test_ETP_check) {
+    ExactTimingParameter etp;
+    TimingParameter tp;
+
+    // 80 MHz timebase, 2 ticks per sample, T = 2000000007 ticks: T * fs is
+    // exactly 1000000003.5, but in doubles it falls just below.
+    ETP_init_ticks(&etp, 80000000, 2, 0, 2000000007);
+    mu_assert_int_eq(0, ETP_check(&etp));
+    mu_check(etp.N == 1000000004);
+    mu_check(etp.fs.num == 40000000 && etp.fs.den == 1);
+    TimingParameter tp_double = {0, 2 / 80e6, 0, 2000000007 / 80e6, 0.1};
+    TP_check(&tp_double);
+    mu_assert_double_eq(1000000003, tp_double.N);
+
+    // fs from N and T stays exact: 3 samples in 1 s.
+    ETP_init_ticks(&etp, 1, 0, 3, 1);
+    mu_assert_int_eq(0, ETP_check(&etp));
+    mu_check(etp.fs.num == 3 && etp.fs.den == 1);
+    mu_check(etp.dt.num == 1 && etp.dt.den == 3);
+    ETP_to_tp(&etp, &tp);
+    double expected[] = {3, 1.0 / 3, 3, 1};
+    check_tp_state(&tp, expected);
+
+    // T from N and fs.
+    etp.fs = rational(80000000, 3);
+    etp.dt = rational(0, 1);
+    etp.N = 1000;
+    etp.T = rational(0, 1);
+    mu_assert_int_eq(0, ETP_check(&etp));
+    mu_check(etp.T.num == 3 && etp.T.den == 80000);
+
+    // The same statuses as TP_check.
+    etp.fs = rational(2, 1);
+    etp.dt = rational(1, 3);
+    mu_assert_int_eq(1, ETP_fs_dt_consistent(&etp));
+    mu_check(etp.dt.num == 1 && etp.dt.den == 2);
+    mu_assert_int_eq(3, ETP_N_T_consistent(&etp));
+    ETP_init_ticks(&etp, 1, 0, 10, 0);
+    mu_assert_int_eq(-1, ETP_check(&etp));
+
+    // Results that don't fit in 64 bits.
+    etp.fs = rational(INT64_MAX, 1);
+    etp.dt = rational(0, 1);
+    etp.N = 0;
+    etp.T = rational(INT64_MAX, 1);
+    mu_assert_int_eq(ETP_OVERFLOW, ETP_check(&etp));
+    // T * fs has a numerator and denominator near 2^126, but N fits.
+    etp.fs = rational(INT64_MAX - 2, INT64_MAX - 4);
+    etp.dt = rational(0, 1);
+    etp.N = 0;
+    etp.T = rational(INT64_MAX, INT64_MAX - 1);
+    mu_assert_int_eq(0, ETP_check(&etp));
+    mu_check(etp.N == 1);
+    // fs = N / T overflows; dt is left undefined rather than 1 / 0.
+    etp.fs = rational(0, 1);
+    etp.dt = rational(0, 1);
+    etp.N = INT64_MAX;
+    etp.T = rational(1, INT64_MAX);
+    mu_assert_int_eq(ETP_OVERFLOW, ETP_N_T_consistent(&etp));
+    mu_check(etp.dt.num == 0 && etp.dt.den == 1);
+
+    // A timebase must be positive.
+    mu_assert_int_eq(-1, ETP_init_ticks(&etp, 0, 2, 10, 20));
+    mu_assert_int_eq(-1, ETP_init_ticks(&etp, -80000000, 2, 10, 20));
+    mu_check(etp.dt.num == 0 && etp.T.num == 0 && etp.N == 0);
+}
+
+// Test that edits only recompute the field that depends on them.
+MU_TEST(test_timing_editor) {
+    TimingEditor te;
+    TE_init(&te);
+    mu_assert_int_eq(TE_FS | TE_DT, TE_set(&te, TE_FS, 100));
+    mu_assert_int_eq(-1, te.status);
+    mu_assert_int_eq(TE_N | TE_T, TE_set(&te, TE_N, 10));
+    mu_assert_int_eq(0, te.status);
+    double expected[] = {100, 0.01, 10, 0.1};
+    check_tp_state(&te.tp, expected);
+    mu_assert_int_eq(TE_T, te.derived & TE_T);
+
+    // T is edited: fs and N were entered, fs longer ago, so fs is derived.
+    mu_assert_int_eq(TE_T | TE_FS | TE_DT, TE_set(&te, TE_T, 0.5));
+    double expected_T[] = {20, 0.05, 10, 0.5};
+    check_tp_state(&te.tp, expected_T);
+    mu_assert_int_eq(TE_FS | TE_DT, te.derived);
+    mu_assert_int_eq(TE_N | TE_T, te.user);
+
+    // Now dt: N was entered longest ago, so N follows.
+    mu_assert_int_eq(TE_DT | TE_FS | TE_N, TE_set(&te, TE_DT, 0.01));
+    double expected_dt[] = {100, 0.01, 50, 0.5};
+    check_tp_state(&te.tp, expected_dt);
+    mu_assert_int_eq(TE_N | TE_FS, te.derived);
+
+    // Setting a field to its current value changes nothing.
+    mu_assert_int_eq(0, TE_set(&te, TE_T, 0.5));
+
+    // A ramp entered field by field ends where RP_check does.
+    TE_init(&te);
+    TE_set(&te, TE_YF, 10);
+    mu_assert_int_eq(TE_DYDT | TE_T, TE_set(&te, TE_DYDT, 2));
+    mu_assert_int_eq(-1, te.status);
+    TE_set(&te, TE_DY, 0.01);
+    mu_assert_int_eq(0, te.status);
+    double expected_ramp[] = {200, 0.005, 1000, 5};
+    check_tp_state(&te.tp, expected_ramp);
+    mu_assert_int_eq(TE_N | TE_T | TE_FS | TE_DT, te.derived);
+    // Half the distance halves N and T; fs = N / T is unchanged.
+    mu_assert_int_eq(TE_YI | TE_T | TE_N, TE_set(&te, TE_YI, 5));
+    double expected_yi[] = {200, 0.005, 500, 2.5};
+    check_tp_state(&te.tp, expected_yi);
+}
+
+// Test that the counters see every branch taken, in every thread.
+MU_TEST(test_instrument) {
+    InstrumentCounters c;
+    TI_reset();
+#ifdef TIMING_INSTRUMENT
+    mu_assert_int_eq(1, TI_enabled());
+    TimingParameter tp;
+    TP_init_inplace(&tp, 100, 0, 10, 0);
+    TP_check(&tp);
+    TP_init_inplace(&tp, 0, 0.01, 0, 2);
+    TP_check(&tp);
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    TP_check(&tp);
+    TI_snapshot(&c);
+    mu_assert_int_eq(1, (int) c.fs_dt[TI_FS_ONLY]);
+    mu_assert_int_eq(1, (int) c.fs_dt[TI_DT_ONLY]);
+    mu_assert_int_eq(1, (int) c.fs_dt[TI_FS_DT_NEITHER]);
+    mu_assert_int_eq(1, (int) c.N_T[TI_NT_T_FROM_N]);
+    mu_assert_int_eq(1, (int) c.N_T[TI_NT_N_FROM_T]);
+    mu_assert_int_eq(1, (int) c.N_T[TI_NT_NOTHING]);
+    mu_assert_int_eq(2, (int) c.status[0 + 2]);
+    mu_assert_int_eq(1, (int) c.status[-1 + 2]);
+    uint64_t timed = 0;
+    for (int b = 0; b < TI_LATENCY_BUCKETS; b++) {
+        timed += c.tp_latency[b];
+    }
+    mu_assert_int_eq(3, (int) timed);
+
+    // Resolutions in worker threads are summed in.
+    enum { n = 3 * SWEEP_CHUNK };
+    double* fs = sweep_alloc(4 * n * sizeof(double));
+    double* dt = fs + n;
+    double* N = dt + n;
+    double* T = N + n;
+    static double eps[n];
+    static int status[n];
+    for (int i = 0; i < n; i++) {
+        fs[i] = 100;
+        dt[i] = 0;
+        N[i] = 0;
+        T[i] = i + 1;
+        eps[i] = 0.1;
+    }
+    TI_reset();
+    TP_check_parallel(fs, dt, N, T, eps, status, n, 4);
+    TI_snapshot(&c);
+    mu_assert_int_eq(n, (int) c.status[0 + 2]);
+
+    // Each sweep starts new threads; they reuse the blocks of the threads
+    // that exited, whose counts are kept.
+    size_t n_blocks = TI_blocks();
+    for (int r = 0; r < 20; r++) {
+        TP_check_parallel(fs, dt, N, T, eps, status, n, 4);
+    }
+    TI_snapshot(&c);
+    mu_assert_int_eq(n, (int) c.status[0 + 2]);
+    mu_assert_int_eq(20 * n, (int) c.status[3 + 2]);   // Already resolved.
+    mu_check(TI_blocks() == n_blocks);
+    free(fs);
+#else
+    mu_assert_int_eq(0, TI_enabled());
+    TimingParameter tp;
+    TP_init_inplace(&tp, 100, 0, 10, 0);
+    TP_check(&tp);
+    TI_snapshot(&c);
+    mu_assert_int_eq(0, (int) c.status[0 + 2]);
+#endif
+}
+
+// Test that DAC-planned ramps use each code at most once.
+MU_TEST(test_dac) {
+    DacSpec dac;
+    mu_assert_int_eq(-1, DAC_init(&dac, 0, -10, 10, 0));
+    mu_assert_int_eq(-1, DAC_init(&dac, 16, 10, -10, 0));
+    mu_assert_int_eq(-1, DAC_init(&dac, 32, 0, 1, 1));
+    mu_assert_int_eq(0, DAC_init(&dac, 16, -10, 10, -32768));
+    mu_assert_int_eq(-32768, DAC_code(&dac, -10));
+    mu_assert_int_eq(32767, DAC_code(&dac, 10));
+    mu_assert_int_eq(32767, DAC_code(&dac, 11));
+    mu_assert_double_eq(10, DAC_snap(&dac, 12));
+    mu_assert_double_eq(-10 + 3 * dac.lsb, DAC_snap(&dac, -10 + 3.4 * dac.lsb));
+
+    // dy well below one LSB is snapped to one LSB.
+    static int16_t codes16[70000];
+    static int32_t codes32[70000];
+    RampParameter rp;
+    TimingParameter tp;
+    RP_init_inplace(&rp, -1.00001, 1, 1, 1e-6);
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_dac(&rp, &tp, &dac));
+    mu_assert_double_eq(dac.lsb, rp.dy);
+    mu_assert_int_eq(0, RP_fill_dac16(&rp, &tp, &dac, codes16, 70000));
+    mu_assert_int_eq(DAC_code(&dac, rp.yi), codes16[0]);
+    mu_assert_int_eq(DAC_code(&dac, 1), codes16[(int) tp.N - 1]);
+    for (int i = 1; i < (int) tp.N; i++) {
+        mu_check(codes16[i] > codes16[i - 1]);
+    }
+
+    // A 12 bit offset binary DAC clocked far faster than its codes change:
+    // N is capped at the codes from yi to yf and fs lowered to keep T.
+    mu_assert_int_eq(0, DAC_init(&dac, 12, 0, 5, 0));
+    RP_init_inplace(&rp, 5, 0, 0.5, 0);
+    TP_init_inplace(&tp, 1e6, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_dac(&rp, &tp, &dac));
+    double expected[] = {4096 / 10.0, 10 / 4096.0, 4096, 10};
+    check_tp_state(&tp, expected);
+    mu_assert_int_eq(-1, RP_fill_dac16(&rp, &tp, &dac, codes16, 4095));
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+        if (simd_set_level(level) != level) {
+            continue;
+        }
+        mu_assert_int_eq(0, RP_fill_dac32(&rp, &tp, &dac, codes32, 70000));
+        for (int i = 0; i < 4096; i++) {
+            mu_assert_int_eq(4095 - i, codes32[i]);
+        }
+    }
+    simd_set_level(-1);
+
+    // int16 buffers only take DACs whose codes fit.
+    mu_assert_int_eq(0, DAC_init(&dac, 20, -10, 10, 0));
+    RP_init_inplace(&rp, 0, 1, 1, 0.01);
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    RP_check_dac(&rp, &tp, &dac);
+    mu_assert_int_eq(-1, RP_fill_dac16(&rp, &tp, &dac, codes16, 70000));
+    mu_assert_int_eq(0, RP_fill_dac32(&rp, &tp, &dac, codes32, 70000));
+    mu_assert_int_eq(DAC_code(&dac, 1), codes32[(int) tp.N - 1]);
+}
+
+// Test shaped ramps against their formulas evaluated per sample.
+MU_TEST(test_RP_shaped) {
+    ShapedRamp sr;
+    TimingParameter tp;
+    static double y[100001];
+
+    // Linear shapes resolve exactly as RP_check.
+    RP_init_inplace(&sr.rp, 0, 10, 2, 0.01);
+    sr.shape = RAMP_LINEAR;
+    sr.k = 0;
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_shaped(&sr, &tp));
+    double expected[] = {200, 0.005, 1000, 5};
+    check_tp_state(&tp, expected);
+
+    // An S-curve is pi / 2 steeper in the middle than a linear ramp.
+    sr.shape = RAMP_SCURVE;
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_shaped(&sr, &tp));
+    mu_assert_double_eq(5 * 3.14159265358979 / 2, tp.T);
+    mu_assert_double_eq(floor(1000 * 3.14159265358979 / 2 + 0.5), tp.N);
+
+    sr.shape = RAMP_LOG;
+    sr.k = -1;
+    mu_assert_int_eq(-1, RP_check_shaped(&sr, &tp));
+    sr.shape = 7;
+    mu_assert_int_eq(-1, RP_check_shaped(&sr, &tp));
+
+    // The small k keep their precision rather than cancelling against 1.
+    static const int shapes[] = {RAMP_EXP, RAMP_EXP, RAMP_LOG, RAMP_LOG,
+                                 RAMP_LOG, RAMP_SCURVE, RAMP_EXP, RAMP_EXP,
+                                 RAMP_EXP, RAMP_LOG, RAMP_LOG};
+    static const double ks[] = {3, -20, 9, -0.9, 1e4, 0, 2e-6, 1e-5, -1e-3,
+                                2e-6, 1e-3};
+    static const double Ns[] = {100001, 37, 100001, 5000, 300, 100001,
+                                100001, 100001, 100001, 100001, 100001};
+    for (size_t c = 0; c < sizeof(shapes) / sizeof(shapes[0]); c++) {
+        RP_init_inplace(&sr.rp, -2, 3, 0, 0);
+        sr.shape = shapes[c];
+        sr.k = ks[c];
+        TP_init_inplace(&tp, 0, 0, Ns[c], 10);
+        mu_assert_int_eq(0, RP_check_shaped(&sr, &tp));
+        mu_assert_int_eq(-1, RP_fill_shaped(&sr, &tp, y, Ns[c] - 1));
+        mu_assert_int_eq(0, RP_fill_shaped(&sr, &tp, y, 100001));
+        int N = (int) tp.N;
+        double max_error = 0;
+        for (int i = 0; i < N; i++) {
+            double s = (double) i / (N - 1);
+            double u;
+            if (sr.shape == RAMP_EXP) {
+                u = expm1(sr.k * s) / expm1(sr.k);
+            }
+            else if (sr.shape == RAMP_LOG) {
+                u = log1p(sr.k * s) / log1p(sr.k);
+            }
+            else {
+                u = (1 - cos(3.14159265358979323846 * s)) / 2;
+            }
+            max_error = fmax(max_error, fabs(y[i] - (-2 + 5 * u)));
+        }
+        mu_check(max_error < 1e-14);
+        mu_assert_double_eq(-2, y[0]);
+        mu_assert_double_eq(3, y[N - 1]);
+    }
+}
+
+// Test that RP_solve finds the limiting constraint.
+MU_TEST(test_RP_solve) {
+    RampParameter rp;
+    TimingParameter tp;
+    HardwareLimit hw = {1000, 0, 0, NULL};
+    unsigned binding;
+    RP_init_inplace(&rp, 0, 10, 2, 0.01);
+
+    // With room to spare the rate limit sets T, as in RP_check.
+    mu_assert_int_eq(0, RP_solve(&rp, &hw, SOLVE_MIN_TIME, &tp, &binding));
+    double expected[] = {200, 0.005, 1000, 5};
+    check_tp_state(&tp, expected);
+    mu_assert_int_eq(SOLVE_RATE | SOLVE_RESOLUTION, binding);
+
+    hw.fs_max = 100;
+    mu_assert_int_eq(0, RP_solve(&rp, &hw, SOLVE_MIN_TIME, &tp, &binding));
+    double expected_fs[] = {100, 0.01, 1000, 10};
+    check_tp_state(&tp, expected_fs);
+    mu_assert_int_eq(SOLVE_FS_MAX | SOLVE_RESOLUTION, binding);
+
+    hw.dt_min = 0.02;
+    mu_assert_int_eq(0, RP_solve(&rp, &hw, SOLVE_MIN_SAMPLES, &tp, &binding));
+    double expected_dt[] = {50, 0.02, 1000, 20};
+    check_tp_state(&tp, expected_dt);
+    mu_assert_int_eq(SOLVE_DT_MIN | SOLVE_RESOLUTION, binding);
+
+    hw.fifo = 500;
+    mu_assert_int_eq(SOLVE_INFEASIBLE,
+                     RP_solve(&rp, &hw, SOLVE_MIN_TIME, &tp, &binding));
+    mu_assert_int_eq(SOLVE_RESOLUTION | SOLVE_FIFO, binding);
+
+    HardwareLimit none = {0, 0, 0, NULL};
+    rp.dydt = 0;
+    mu_assert_int_eq(-1, RP_solve(&rp, &none, SOLVE_MIN_TIME, &tp, NULL));
+
+    // A card with rates 1 MHz / 3 ... 1 MHz / 100000. N_min = 971 samples
+    // over 5 s needs 194.2 Hz, which the card can't make.
+    SampleClock sc;
+    mu_assert_int_eq(0, SC_init(&sc, 1e6, 3, 100000));
+    mu_assert_double_eq(1e6 / 5150, SC_floor(&sc, 194.2, NULL));
+    mu_assert_double_eq(0, SC_floor(&sc, 9.99, NULL));
+    HardwareLimit card = {0, 0, 0, &sc};
+    SampleClock empty;
+    SC_init(&empty, 0, 1, 1);
+    HardwareLimit no_rates = {0, 0, 0, &empty};
+    mu_assert_int_eq(-1, RP_solve(&rp, &no_rates, SOLVE_MIN_TIME, &tp, NULL));
+    RP_init_inplace(&rp, 0, 10, 2, 0.0103);
+    mu_assert_int_eq(0, RP_solve(&rp, &card, SOLVE_MIN_SAMPLES, &tp, &binding));
+    mu_assert_double_eq(1e6 / 5150, tp.fs);
+    mu_assert_double_eq(971, tp.N);
+    mu_assert_int_eq(SOLVE_RATE | SOLVE_RESOLUTION | SOLVE_CLOCK, binding);
+
+    // The fastest time oversamples to hit the rate limit exactly; of the
+    // rates that do, the one needing fewest samples is chosen.
+    mu_assert_int_eq(0, RP_solve(&rp, &card, SOLVE_MIN_TIME, &tp, &binding));
+    double expected_time[] = {15625, 6.4e-5, 78125, 5};
+    check_tp_state(&tp, expected_time);
+    mu_assert_int_eq(SOLVE_RATE, binding);
+
+    // A FIFO of 971 samples leaves only the slow solution.
+    card.fifo = 971;
+    mu_assert_int_eq(0, RP_solve(&rp, &card, SOLVE_MIN_TIME, &tp, &binding));
+    mu_assert_double_eq(1e6 / 5150, tp.fs);
+    mu_assert_double_eq(971, tp.N);
+    mu_assert_int_eq(SOLVE_RATE | SOLVE_RESOLUTION | SOLVE_FIFO | SOLVE_CLOCK,
+                     binding);
+    SC_free(&sc);
+}
+
+MU_TEST(test_status_message) {
+    mu_check(strcmp("consistent", TP_status_message(0)) == 0);
+    mu_check(strcmp("no timing satisfies the hardware limits",
+                    TP_status_message(SOLVE_INFEASIBLE)) == 0);
+    mu_check(strcmp("exact result does not fit in 64 bits",
+                    TP_status_message(ETP_OVERFLOW)) == 0);
+    mu_check(strcmp("unknown status", TP_status_message(4)) == 0);
+    mu_check(strcmp("unknown status", TP_status_message(-5)) == 0);
+    // TP_check never returns fs_dt_consistent's 1 and 2.
+    mu_check(strcmp("unknown status", TP_status_message(1)) == 0);
+    mu_check(strcmp("unknown status", TP_status_message(INT_MIN)) == 0);
+
+    double fs[] = {100, 0, 0, 0, 100, 0};
+    double dt[] = {0, 0, 0, 0, 0.01, 0};
+    double N[] = {10, 0, 0, 20, 10, 30};
+    double T[] = {0, 0, 0, 0, 0.1, 3};
+    double eps[] = {0.1, 0.1, 0.1, 0.1, 0.1, 0.1};
+    int status[9];
+    TP_check_batch(fs, dt, N, T, eps, status, 6);
+    status[6] = INT_MAX;
+    status[7] = 1;
+    status[8] = INT_MIN;
+    TimingDiagnostic diag;
+    mu_assert_int_eq(4, (int) TP_diagnose(status, 9, &diag));
+    mu_check(diag.n_unknown == 3);
+    mu_check(diag.count[0 - TP_STATUS_MIN] == 2);
+    mu_check(diag.first[0 - TP_STATUS_MIN] == 0);
+    mu_check(diag.count[-1 - TP_STATUS_MIN] == 3);
+    mu_check(diag.first[-1 - TP_STATUS_MIN] == 1);
+    mu_check(diag.first[-2 - TP_STATUS_MIN] == 9);
+
+    const char* report = "9 statuses, 4 errors\n"
+        "-1: 3, first at 1: not enough parameters: need fs or dt with N or T, "
+        "or both N and T\n"
+        "0: 2, first at 0: consistent\n"
+        "3: 1, first at 4: fs, dt, N and T all defined; left unchanged\n"
+        "unknown: 3\n";
+    char buf[256];
+    mu_check(TP_diagnostic_text(&diag, buf, sizeof(buf)) == strlen(report));
+    mu_check(strcmp(report, buf) == 0);
+    // A short buffer gets a terminated prefix and the full length back.
+    char small[8];
+    mu_check(TP_diagnostic_text(&diag, small, sizeof(small)) == strlen(report));
+    mu_check(strcmp("9 statu", small) == 0);
+
+    // An undescribed status ahead of a known one does not take its place.
+    int leading[] = {1, 0, 2, 0};
+    mu_assert_int_eq(0, (int) TP_diagnose(leading, 4, &diag));
+    mu_check(diag.n_unknown == 2);
+    mu_check(diag.count[0 - TP_STATUS_MIN] == 2);
+    mu_check(diag.first[0 - TP_STATUS_MIN] == 1);
+    mu_check(diag.first[1 - TP_STATUS_MIN] == 4);
+}
+
+// Test that ramps on a shared clock get one timing, and that both layouts
+// hold exactly the samples RP_fill gives each channel.
+MU_TEST(test_RP_channels) {
+    RampParameter rp[3];
+    RP_init_inplace(&rp[0], 0, 10, 2, 0.01);    // 5 s at 200 Hz
+    RP_init_inplace(&rp[1], 1, 0, 1, 0.01);     // 1 s at 100 Hz
+    RP_init_inplace(&rp[2], 3, 3, 1, 0.01);     // Held; sets nothing.
+    TimingParameter tp;
+    TP_init_inplace(&tp, 0, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_channels(rp, 3, &tp));
+    double expected[] = {200, 0.005, 1000, 5};
+    check_tp_state(&tp, expected);
+
+    size_t n = 1000;
+    double* by_sample = malloc(3 * n * sizeof(double));
+    double* by_channel = malloc(3 * n * sizeof(double));
+    int16_t* codes_sample = malloc(3 * n * sizeof(int16_t));
+    int16_t* codes_channel = malloc(3 * n * sizeof(int16_t));
+    double* y = malloc(n * sizeof(double));
+    int16_t* codes = malloc(n * sizeof(int16_t));
+    mu_assert_int_eq(-1, RP_fill_channels(rp, 3, &tp, RAMP_BY_SAMPLE,
+                                          by_sample, NULL, 1, 0, 3 * n - 1));
+    mu_assert_int_eq(-1, RP_fill_channels(rp, 3, &tp, 2, by_sample, NULL, 1,
+                                          0, 3 * n));
+    mu_assert_int_eq(0, RP_fill_channels(rp, 3, &tp, RAMP_BY_SAMPLE,
+                                         by_sample, codes_sample, 3276.7, 0,
+                                         3 * n));
+    mu_assert_int_eq(0, RP_fill_channels(rp, 3, &tp, RAMP_BY_CHANNEL,
+                                         by_channel, codes_channel, 3276.7, 0,
+                                         3 * n));
+    for (size_t k = 0; k < 3; k++) {
+        RP_fill(&rp[k], &tp, y, codes, 3276.7, 0, n);
+        int same = 1;
+        for (size_t i = 0; i < n; i++) {
+            same &= by_sample[i * 3 + k] == y[i];
+            same &= by_channel[k * n + i] == y[i];
+            same &= codes_sample[i * 3 + k] == codes[i];
+            same &= codes_channel[k * n + i] == codes[i];
+        }
+        mu_check(same);
+    }
+    mu_assert_double_eq(0, by_sample[3 * (n - 1) + 1]);
+
+    // A channel with neither a rate nor a resolution can't be timed.
+    RP_init_inplace(&rp[2], 3, 4, 0, 0);
+    mu_assert_int_eq(-1, RP_check_channels(rp, 3, &tp));
+
+    // Rate limited channels on a card clocked at a fixed fs.
+    RP_init_inplace(&rp[0], 0, 10, 2, 0);
+    RP_init_inplace(&rp[1], 0, 5, 1, 0);
+    TP_init_inplace(&tp, 1000, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_channels(rp, 2, &tp));
+    double expected_fs[] = {1000, 0.001, 5000, 5};
+    check_tp_state(&tp, expected_fs);
+    // Resolution limited channels take their duration from fs.
+    RP_init_inplace(&rp[0], 0, 10, 0, 0.01);
+    RP_init_inplace(&rp[1], 0, 5, 0, 0.01);
+    TP_init_inplace(&tp, 1000, 0, 0, 0);
+    mu_assert_int_eq(0, RP_check_channels(rp, 2, &tp));
+    double expected_dy[] = {1000, 0.001, 1000, 1};
+    check_tp_state(&tp, expected_dy);
+    free(by_sample);
+    free(by_channel);
+    free(codes_sample);
+    free(codes_channel);
+    free(y);
+    free(codes);
+}
+
 // Set up the test suite.
 MU_TEST_SUITE(test_suite) {
     MU_RUN_TEST(test_TP_init);
+    MU_RUN_TEST(test_init_inplace);
     MU_RUN_TEST(test_fs_dt_consistent);
     MU_RUN_TEST(test_TP_check);
+    MU_RUN_TEST(test_TP_check_batch);
+    MU_RUN_TEST(test_TP_check_batch_simd);
+    MU_RUN_TEST(test_TP_check_batch_fixed);
     MU_RUN_TEST(test_RP_check);
+    MU_RUN_TEST(test_RP_fill);
+    MU_RUN_TEST(test_RS_next);
+    MU_RUN_TEST(test_SEQ_plan);
+    MU_RUN_TEST(test_SEQ_plan_clocked);
+    MU_RUN_TEST(test_TP_check_hw);
+    MU_RUN_TEST(test_resolve_cache);
+    MU_RUN_TEST(test_parse_double);
+    MU_RUN_TEST(test_record_reader);
+    MU_RUN_TEST(test_check_parallel);
+    MU_RUN_TEST(test_grid_sweep);
+    MU_RUN_TEST(test_sample_ring);
+    MU_RUN_TEST(test_ETP_check);
+    MU_RUN_TEST(test_timing_editor);
+    MU_RUN_TEST(test_instrument);
+    MU_RUN_TEST(test_dac);
+    MU_RUN_TEST(test_RP_shaped);
+    MU_RUN_TEST(test_RP_solve);
+    MU_RUN_TEST(test_status_message);
+    MU_RUN_TEST(test_RP_channels);
+#ifndef _WIN32
+    MU_RUN_TEST(test_wavefile);
+#endif
 }
 
 // Run the test suite, and report the results.
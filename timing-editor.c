@@ -0,0 +1,171 @@
+/// timing-editor.c
+/// Re-resolve timing incrementally as the user edits one front panel field.
+///
+/// TP_check treats 0 as "undefined" and recomputes everything on every call,
+/// and RP_check recomputes N and T from all four ramp fields. A TimingEditor
+/// instead remembers which fields the user entered. The timing has three
+/// degrees of freedom: the rate (fs or dt, which always determine each
+/// other), N and T. The two that were given a value most recently are the
+/// inputs and the third is derived from them, so editing T with fs and N
+/// already entered recomputes N if fs was entered after N, and fs otherwise.
+/// Ramp edits feed the same scheme: dydt gives T and dy gives N, as in
+/// RP_check, and editing yi or yf refreshes whichever of those the ramp sets.
+/// TE_set reports exactly which fields changed, so the front panel only
+/// updates those.
+
+#include <string.h>
+#include <tgmath.h>
+#include "timing-editor.h"
+
+#define RATE 0
+#define COUNT 1
+#define TIME 2
+
+/// Start with every field undefined.
+void TE_init(TimingEditor* te) {
+    memset(te, 0, sizeof(TimingEditor));
+    TP_init_inplace(&te->tp, 0, 0, 0, 0);
+    RP_init_inplace(&te->rp, 0, 0, 0, 0);
+    te->status = -1;
+}
+
+static void touch(TimingEditor* te, int degree) {
+    te->stamp[degree] = ++te->clock;
+}
+
+// Recompute the degree of freedom that was given a value least recently.
+static void derive(TimingEditor* te) {
+    TimingParameter* tp = &te->tp;
+    int oldest = RATE;
+    for (int d = COUNT; d <= TIME; d++) {
+        if (te->stamp[d] < te->stamp[oldest]) {
+            oldest = d;
+        }
+    }
+    te->derived = te->from_ramp;
+    int rate_ok = te->stamp[RATE] && tp->fs > 0 && tp->dt > 0;
+    int N_ok = te->stamp[COUNT] && tp->N > 0;
+    int T_ok = te->stamp[TIME] && tp->T > 0;
+    te->status = 0;
+    if (oldest == TIME && rate_ok && N_ok) {
+        tp->T = tp->N / tp->fs;
+        te->derived |= TE_T;
+    }
+    else if (oldest == COUNT && rate_ok && T_ok) {
+        tp->N = floor(tp->T * tp->fs + 0.5);
+        te->derived |= TE_N;
+    }
+    else if (oldest == RATE && N_ok && T_ok) {
+        tp->fs = tp->N / tp->T;
+        tp->dt = 1.0 / tp->fs;
+        te->derived |= TE_FS | TE_DT;
+    }
+    else {
+        te->status = -1;
+    }
+    // Whichever of fs and dt the user didn't enter follows the other.
+    if (te->user & TE_FS) {
+        te->derived |= TE_DT;
+    }
+    if (te->user & TE_DT) {
+        te->derived |= TE_FS;
+    }
+    te->user &= ~te->derived;
+}
+
+// N and T from the ramp fields, as in RP_check.
+static void ramp_timing(TimingEditor* te) {
+    RampParameter* rp = &te->rp;
+    double y_Delta = fmax(fabs(rp->yf - rp->yi), rp->y_Delta_min);
+    if (rp->dydt > 0) {
+        te->tp.T = y_Delta / rp->dydt;
+        te->user &= ~TE_T;
+        te->from_ramp |= TE_T;
+        if (!te->stamp[TIME]) {
+            touch(te, TIME);
+        }
+    }
+    if (rp->dy > 0) {
+        te->tp.N = fmax(floor(y_Delta / rp->dy + 0.5), 2);
+        te->user &= ~TE_N;
+        te->from_ramp |= TE_N;
+        if (!te->stamp[COUNT]) {
+            touch(te, COUNT);
+        }
+    }
+}
+
+/// Set one field (TE_FS ... TE_DY) to value and update the fields that
+/// depend on it. te->status is 0 once the timing is fully determined, or -1
+/// while fewer than two of rate, N and T have valid values.
+/// Returns the mask of fields whose value changed.
+unsigned TE_set(TimingEditor* te, unsigned field, double value) {
+    TimingParameter before_tp = te->tp;
+    RampParameter before_rp = te->rp;
+    TimingParameter* tp = &te->tp;
+
+    switch (field) {
+    case TE_FS:
+        tp->fs = value;
+        tp->dt = 1.0 / value;
+        te->user = (te->user & ~TE_DT) | TE_FS;
+        touch(te, RATE);
+        break;
+    case TE_DT:
+        tp->dt = value;
+        tp->fs = 1.0 / value;
+        te->user = (te->user & ~TE_FS) | TE_DT;
+        touch(te, RATE);
+        break;
+    case TE_N:
+        tp->N = value;
+        te->user |= TE_N;
+        te->from_ramp &= ~TE_N;
+        touch(te, COUNT);
+        break;
+    case TE_T:
+        tp->T = value;
+        te->user |= TE_T;
+        te->from_ramp &= ~TE_T;
+        touch(te, TIME);
+        break;
+    case TE_DYDT:
+        te->rp.dydt = value;
+        te->user |= TE_DYDT;
+        if (value > 0) {
+            touch(te, TIME);
+        }
+        ramp_timing(te);
+        break;
+    case TE_DY:
+        te->rp.dy = value;
+        te->user |= TE_DY;
+        if (value > 0) {
+            touch(te, COUNT);
+        }
+        ramp_timing(te);
+        break;
+    case TE_YI:
+    case TE_YF:
+        *(field == TE_YI ? &te->rp.yi : &te->rp.yf) = value;
+        te->user |= field;
+        ramp_timing(te);
+        break;
+    default:
+        return 0;
+    }
+    derive(te);
+
+    double* now[] = {&tp->fs, &tp->dt, &tp->N, &tp->T,
+                     &te->rp.yi, &te->rp.yf, &te->rp.dydt, &te->rp.dy};
+    double* was[] = {&before_tp.fs, &before_tp.dt, &before_tp.N, &before_tp.T,
+                     &before_rp.yi, &before_rp.yf, &before_rp.dydt,
+                     &before_rp.dy};
+    unsigned changed = 0;
+    for (int i = 0; i < 8; i++) {
+        if (memcmp(now[i], was[i], sizeof(double)) != 0) {
+            changed |= 1u << i;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,36 @@
+// Timing Editor Header
+// Incremental re-resolution of timing and ramp parameters, one edited field
+// at a time.
+#ifndef __TIMINGEDITOR_H__
+#define __TIMINGEDITOR_H__
+
+#include <stdint.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+// Field bits, used for TE_set and in the masks it reports.
+#define TE_FS   0x01
+#define TE_DT   0x02
+#define TE_N    0x04
+#define TE_T    0x08
+#define TE_YI   0x10
+#define TE_YF   0x20
+#define TE_DYDT 0x40
+#define TE_DY   0x80
+
+typedef struct TimingEditors {
+    TimingParameter tp;
+    RampParameter rp;
+    unsigned user;          // Fields whose value the user entered.
+    unsigned derived;       // Fields computed from other fields.
+    unsigned from_ramp;     // N and/or T when set from dy and dydt.
+    uint64_t stamp[3];      // When the rate (fs or dt), N and T were last
+    uint64_t clock;         // given a value; 0 if never.
+    int status;             // 0, or -1 if the timing is underdetermined.
+} TimingEditor;
+
+void TE_init(TimingEditor* te);
+
+unsigned TE_set(TimingEditor* te, unsigned field, double value);
+
+#endif /* __TIMINGEDITOR_H__ */
@@ -0,0 +1,171 @@
+/// wavefile.c
+/// Store generated ramps as binary files that are read and written through
+/// mmap.
+///
+/// A file is a WaveHeader recording the resolved TimingParameter and
+/// RampParameter and the sample type, followed by the raw samples (doubles or
+/// int16 DAC codes) at a 64 byte aligned offset. WF_create sizes the file and
+/// maps it, so RP_fill (or a RampStream) generates straight into the page
+/// cache with no intermediate buffer. WF_open maps an existing file read-only;
+/// opening is instant whatever the size, and pages are read only when the
+/// samples are touched.
+///
+/// mmap is POSIX only, so this file is empty in Windows builds.
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <tgmath.h>
+#include "wavefile.h"
+
+typedef char wave_header_size_check[sizeof(WaveHeader) == WF_HEADER_SIZE ? 1 : -1];
+
+static size_t sample_size(int sample_type) {
+    return sample_type == WF_INT16 ? sizeof(int16_t) : sizeof(double);
+}
+
+static int WF_map(WaveFile* wf, int prot) {
+    void* map = mmap(NULL, wf->map_size, prot, MAP_SHARED, wf->fd, 0);
+    if (map == MAP_FAILED) {
+        close(wf->fd);
+        return -1;
+    }
+    wf->header = map;
+    return 0;
+}
+
+/// Create (or replace) the file at path for the tp->N samples of the ramp rp
+/// resolved into tp, map it, and fill in the header. The caller writes the
+/// samples to wf->data and then calls WF_close.
+/// Returns 0, or -1 if tp->N is not a whole number >= 2, sample_type is
+/// unknown, or the file can't be created or mapped.
+int WF_create(WaveFile* wf, const char* path, RampParameter* rp,
+              TimingParameter* tp, int sample_type, double scale,
+              double offset) {
+    if (!(tp->N >= 2) || tp->N != floor(tp->N) ||
+        (sample_type != WF_DOUBLE && sample_type != WF_INT16)) {
+        return -1;
+    }
+    uint64_t n = (uint64_t) tp->N;
+    uint64_t data_offset = (WF_HEADER_SIZE + 63) / 64 * 64;
+    wf->map_size = data_offset + n * sample_size(sample_type);
+    wf->writable = 1;
+    wf->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (wf->fd < 0) {
+        return -1;
+    }
+    if (ftruncate(wf->fd, (off_t) wf->map_size) != 0) {
+        close(wf->fd);
+        return -1;
+    }
+    if (WF_map(wf, PROT_READ | PROT_WRITE) != 0) {
+        return -1;
+    }
+    WaveHeader* h = wf->header;
+    memset(h, 0, sizeof(WaveHeader));
+    memcpy(h->magic, WF_MAGIC, sizeof(h->magic));
+    h->version = WF_VERSION;
+    h->sample_type = (uint32_t) sample_type;
+    h->n_samples = n;
+    h->data_offset = data_offset;
+    h->fs = tp->fs;
+    h->dt = tp->dt;
+    h->N = tp->N;
+    h->T = tp->T;
+    h->eps = tp->eps;
+    h->yi = rp->yi;
+    h->yf = rp->yf;
+    h->dydt = rp->dydt;
+    h->dy = rp->dy;
+    h->y_Delta_min = rp->y_Delta_min;
+    h->scale = scale;
+    h->offset = offset;
+    wf->data = (char*) h + data_offset;
+    return 0;
+}
+
+/// Generate the ramp rp resolved into tp directly into a new file at path.
+/// Returns 0, or -1 on failure.
+int WF_write_ramp(const char* path, RampParameter* rp, TimingParameter* tp,
+                  int sample_type, double scale, double offset) {
+    WaveFile wf;
+    if (WF_create(&wf, path, rp, tp, sample_type, scale, offset) != 0) {
+        return -1;
+    }
+    size_t n = wf.header->n_samples;
+    if (sample_type == WF_INT16) {
+        RP_fill(rp, tp, NULL, wf.data, scale, offset, n);
+    }
+    else {
+        RP_fill(rp, tp, wf.data, NULL, scale, offset, n);
+    }
+    return WF_close(&wf);
+}
+
+/// Map the file at path read-only and check its header.
+/// Returns 0, or -1 if it can't be opened or is not a valid waveform file.
+int WF_open(WaveFile* wf, const char* path) {
+    struct stat st;
+    wf->writable = 0;
+    wf->fd = open(path, O_RDONLY);
+    if (wf->fd < 0) {
+        return -1;
+    }
+    if (fstat(wf->fd, &st) != 0 || (size_t) st.st_size < WF_HEADER_SIZE) {
+        close(wf->fd);
+        return -1;
+    }
+    wf->map_size = (size_t) st.st_size;
+    if (WF_map(wf, PROT_READ) != 0) {
+        return -1;
+    }
+    WaveHeader* h = wf->header;
+    if (memcmp(h->magic, WF_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != WF_VERSION || h->sample_type > WF_INT16 ||
+        h->data_offset < WF_HEADER_SIZE ||
+        h->data_offset > wf->map_size ||
+        h->n_samples > (wf->map_size - h->data_offset) /
+                       sample_size(h->sample_type)) {
+        munmap(h, wf->map_size);
+        close(wf->fd);
+        return -1;
+    }
+    madvise(h, wf->map_size, MADV_SEQUENTIAL);
+    wf->data = (char*) h + h->data_offset;
+    return 0;
+}
+
+/// Unmap and close the file, flushing the samples of a file being written.
+/// Returns 0, or -1 if the flush fails.
+int WF_close(WaveFile* wf) {
+    int status = 0;
+    if (wf->writable && msync(wf->header, wf->map_size, MS_SYNC) != 0) {
+        status = -1;
+    }
+    munmap(wf->header, wf->map_size);
+    close(wf->fd);
+    wf->header = NULL;
+    wf->data = NULL;
+    return status;
+}
+
+/// Copy the parameters recorded in the header into rp and tp.
+void WF_parameters(WaveFile* wf, RampParameter* rp, TimingParameter* tp) {
+    WaveHeader* h = wf->header;
+    tp->fs = h->fs;
+    tp->dt = h->dt;
+    tp->N = h->N;
+    tp->T = h->T;
+    tp->eps = h->eps;
+    rp->yi = h->yi;
+    rp->yf = h->yf;
+    rp->dydt = h->dydt;
+    rp->dy = h->dy;
+    rp->y_Delta_min = h->y_Delta_min;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,65 @@
+// Wave File Header
+// A binary, memory-mapped file format for generated waveforms.
+#ifndef __WAVEFILE_H__
+#define __WAVEFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "check-timing.h"
+#include "ramp.h"
+
+#define WF_MAGIC "TLWAVE\r\n"
+#define WF_VERSION 1
+
+// Sample types.
+#define WF_DOUBLE 0
+#define WF_INT16  1
+
+// The first WF_HEADER_SIZE bytes of the file; the samples start at
+// data_offset. All fields are in the byte order of the machine that wrote
+// the file.
+typedef struct WaveHeaders {
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_type;
+    uint64_t n_samples;
+    uint64_t data_offset;
+    double fs;              // The resolved TimingParameter.
+    double dt;
+    double N;
+    double T;
+    double eps;
+    double yi;              // The RampParameter.
+    double yf;
+    double dydt;
+    double dy;
+    double y_Delta_min;
+    double scale;           // WF_INT16: code = y * scale + offset.
+    double offset;
+    char reserved[32];
+} WaveHeader;
+
+#define WF_HEADER_SIZE 160
+
+typedef struct WaveFiles {
+    WaveHeader* header;     // Points into the mapping.
+    void* data;             // n_samples doubles or int16 codes.
+    size_t map_size;
+    int fd;
+    int writable;
+} WaveFile;
+
+int WF_create(WaveFile* wf, const char* path, RampParameter* rp,
+              TimingParameter* tp, int sample_type, double scale,
+              double offset);
+
+int WF_write_ramp(const char* path, RampParameter* rp, TimingParameter* tp,
+                  int sample_type, double scale, double offset);
+
+int WF_open(WaveFile* wf, const char* path);
+
+int WF_close(WaveFile* wf);
+
+void WF_parameters(WaveFile* wf, RampParameter* rp, TimingParameter* tp);
+
+#endif /* __WAVEFILE_H__ */